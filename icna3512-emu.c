@@ -0,0 +1,846 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Software stand-in for an ICNA3512 panel on a DSI link.
+ *
+ * Registers a fake DSI host with one device, bound explicitly to
+ * panel-chipone-icna3512 (the driver name does not fit a DSI device name,
+ * so the bus cannot match it), together with the supplies (vddp, iovcc)
+ * and GPIOs (reset, dcdc-en) the driver asks for. Behind the
+ * host sits a register level model of the IC: paged user registers behind
+ * the 9C/FD keys, sleep and display state, DBV, power mode and ID readback.
+ * Every packet is charged a configurable LP or HS link cost so the driver
+ * can be timed end to end on any machine.
+ *
+ *	make EMU=1
+ *	insmod panel-chipone-icna3512.ko
+ *	insmod icna3512-emu.ko id=0x00,0x01,0x00 lp_byte_ns=800
+ *
+ * State, link statistics and a register dump are in debugfs under
+ * icna3512-emu/. Writing to the stats file clears the counters.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/gpio/driver.h>
+#include <linux/gpio/machine.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/regulator/driver.h>
+#include <linux/regulator/machine.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#include <video/mipi_display.h>
+
+#include <drm/drm_mipi_dsi.h>
+
+#define ICNA3512_EMU_NAME		"icna3512-emu"
+#define ICNA3512_EMU_SUPPLY_NAME	"icna3512-emu-supply"
+#define ICNA3512_EMU_DSI_NAME		ICNA3512_EMU_NAME ".0"
+#define ICNA3512_EMU_DRIVER_NAME	"panel-chipone-icna3512"
+
+#define ICNA3512_EMU_NUM_PAGES		16
+#define ICNA3512_EMU_REG_LEN		32
+
+/* SLP OUT to next command, and SLP OUT to SLP IN, from the datasheet */
+#define ICNA3512_EMU_SLPOUT_CMD_MS	5
+#define ICNA3512_EMU_SLPOUT_SLPIN_MS	120
+
+static unsigned int lp_byte_ns = 800;
+module_param(lp_byte_ns, uint, 0644);
+MODULE_PARM_DESC(lp_byte_ns, "LP escape mode cost per byte on the wire (ns)");
+
+static unsigned int hs_byte_ns = 2;
+module_param(hs_byte_ns, uint, 0644);
+MODULE_PARM_DESC(hs_byte_ns, "HS cost per byte on the wire, all lanes (ns)");
+
+static unsigned int lp_packet_ns = 4000;
+module_param(lp_packet_ns, uint, 0644);
+MODULE_PARM_DESC(lp_packet_ns, "LP per packet overhead, escape entry and exit (ns)");
+
+static unsigned int hs_packet_ns = 2000;
+module_param(hs_packet_ns, uint, 0644);
+MODULE_PARM_DESC(hs_packet_ns, "HS per packet overhead, HS entry and exit (ns)");
+
+static unsigned int bta_ns = 20000;
+module_param(bta_ns, uint, 0644);
+MODULE_PARM_DESC(bta_ns, "bus turnaround cost of a read, both directions (ns)");
+
+static u8 id[3];
+module_param_array(id, byte, NULL, 0644);
+MODULE_PARM_DESC(id, "DCS ID1,ID2,ID3 reported by the panel");
+
+enum icna3512_emu_gpio {
+	ICNA3512_EMU_GPIO_RESET,
+	ICNA3512_EMU_GPIO_DCDC_EN,
+	ICNA3512_EMU_NUM_GPIOS,
+};
+
+static const char * const icna3512_emu_supplies[] = {
+	"vddp",
+	"iovcc",
+};
+
+struct icna3512_emu_reg {
+	u8 len;
+	u8 val[ICNA3512_EMU_REG_LEN];
+};
+
+struct icna3512_emu_stats {
+	u64 packets[2];		/* [0] HS, [1] LP */
+	u64 bytes[2];
+	u64 reads;
+	u64 link_ns;
+	u64 resets;
+	u64 violations;
+	char last_violation[64];
+};
+
+struct icna3512_emu {
+	struct device *host_dev;
+	struct device *supply_dev;
+	struct mipi_dsi_host host;
+	struct mipi_dsi_device *dsi;
+
+	struct gpio_chip gc;
+	struct gpiod_lookup_table *lookup;
+
+	struct regulator_desc reg_desc[ARRAY_SIZE(icna3512_emu_supplies)];
+	struct regulator_consumer_supply reg_supply[ARRAY_SIZE(icna3512_emu_supplies)];
+	struct regulator_init_data reg_init[ARRAY_SIZE(icna3512_emu_supplies)];
+	struct regulator_dev *rdev[ARRAY_SIZE(icna3512_emu_supplies)];
+	char reg_name[ARRAY_SIZE(icna3512_emu_supplies)][32];
+
+	struct dentry *debugfs;
+
+	/*
+	 * The driver toggles reset with gpiod_set_value(), so the pins are
+	 * under a spinlock and a reset release is only flagged there; the
+	 * model catches up under the mutex on its next use.
+	 */
+	spinlock_t pin_lock;
+	int gpio_val[ICNA3512_EMU_NUM_GPIOS];
+	bool in_reset;
+	bool reset_pending;
+
+	/* protects everything below, held across the simulated link time */
+	struct mutex lock;
+
+	bool supply_on[ARRAY_SIZE(icna3512_emu_supplies)];
+
+	/* IC state, back to defaults on reset */
+	bool sleep;
+	bool display_on;
+	bool idle;
+	bool key_9c;
+	bool key_fd;
+	u16 dbv;
+	u8 page;
+	u16 max_return;
+	ktime_t slpout_ts;
+	struct icna3512_emu_reg (*regs)[256];
+
+	struct icna3512_emu_stats stats;
+};
+
+static struct icna3512_emu *icna3512_emu;
+
+static bool icna3512_emu_is_dcs(u8 cmd)
+{
+	switch (cmd) {
+	case MIPI_DCS_SOFT_RESET:
+	case MIPI_DCS_GET_DISPLAY_ID:
+	case MIPI_DCS_GET_POWER_MODE:
+	case MIPI_DCS_ENTER_SLEEP_MODE:
+	case MIPI_DCS_EXIT_SLEEP_MODE:
+	case MIPI_DCS_SET_DISPLAY_OFF:
+	case MIPI_DCS_SET_DISPLAY_ON:
+	case MIPI_DCS_SET_TEAR_OFF:
+	case MIPI_DCS_SET_TEAR_ON:
+	case MIPI_DCS_EXIT_IDLE_MODE:
+	case MIPI_DCS_ENTER_IDLE_MODE:
+	case MIPI_DCS_SET_DISPLAY_BRIGHTNESS:
+	case MIPI_DCS_GET_DISPLAY_BRIGHTNESS:
+	case MIPI_DCS_WRITE_CONTROL_DISPLAY:
+	case MIPI_DCS_GET_CONTROL_DISPLAY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void icna3512_emu_violation(struct icna3512_emu *emu, const char *what, u8 cmd)
+{
+	emu->stats.violations++;
+	snprintf(emu->stats.last_violation, sizeof(emu->stats.last_violation),
+		 "%s (cmd %02x)", what, cmd);
+	dev_dbg(emu->host_dev, "%s\n", emu->stats.last_violation);
+}
+
+static bool icna3512_emu_alive(struct icna3512_emu *emu)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(emu->supply_on); i++)
+		if (!emu->supply_on[i])
+			return false;
+
+	return !READ_ONCE(emu->in_reset);
+}
+
+/* Hardware reset, or power loss: everything reloads from OTP */
+static void icna3512_emu_reset(struct icna3512_emu *emu)
+{
+	emu->sleep = true;
+	emu->display_on = false;
+	emu->idle = false;
+	emu->key_9c = false;
+	emu->key_fd = false;
+	emu->dbv = 0;
+	emu->page = 0;
+	emu->max_return = 1;
+	emu->slpout_ts = 0;
+	memset(emu->regs, 0, sizeof(*emu->regs) * ICNA3512_EMU_NUM_PAGES);
+}
+
+/* Apply a reset release seen on the pin, call with emu->lock held */
+static void icna3512_emu_sync_pins(struct icna3512_emu *emu)
+{
+	bool reset;
+
+	spin_lock_irq(&emu->pin_lock);
+	reset = emu->reset_pending;
+	emu->reset_pending = false;
+	spin_unlock_irq(&emu->pin_lock);
+
+	if (reset) {
+		icna3512_emu_reset(emu);
+		emu->stats.resets++;
+	}
+}
+
+static void icna3512_emu_check_timing(struct icna3512_emu *emu, u8 cmd)
+{
+	s64 since;
+
+	if (!emu->slpout_ts)
+		return;
+
+	since = ktime_ms_delta(ktime_get(), emu->slpout_ts);
+
+	if (cmd == MIPI_DCS_ENTER_SLEEP_MODE && since < ICNA3512_EMU_SLPOUT_SLPIN_MS)
+		icna3512_emu_violation(emu, "SLP IN too soon after SLP OUT", cmd);
+	else if (since < ICNA3512_EMU_SLPOUT_CMD_MS)
+		icna3512_emu_violation(emu, "command too soon after SLP OUT", cmd);
+}
+
+static void icna3512_emu_write(struct icna3512_emu *emu, u8 cmd,
+			       const u8 *par, size_t len)
+{
+	struct icna3512_emu_reg *reg;
+	bool dcs = icna3512_emu_is_dcs(cmd);
+
+	icna3512_emu_check_timing(emu, cmd);
+
+	switch (cmd) {
+	case MIPI_DCS_SOFT_RESET:
+		icna3512_emu_reset(emu);
+		emu->stats.resets++;
+		return;
+	case MIPI_DCS_ENTER_SLEEP_MODE:
+		emu->sleep = true;
+		emu->slpout_ts = 0;
+		break;
+	case MIPI_DCS_EXIT_SLEEP_MODE:
+		emu->sleep = false;
+		emu->slpout_ts = ktime_get();
+		break;
+	case MIPI_DCS_SET_DISPLAY_OFF:
+		emu->display_on = false;
+		break;
+	case MIPI_DCS_SET_DISPLAY_ON:
+		emu->display_on = true;
+		break;
+	case MIPI_DCS_ENTER_IDLE_MODE:
+		emu->idle = true;
+		break;
+	case MIPI_DCS_EXIT_IDLE_MODE:
+		emu->idle = false;
+		break;
+	case MIPI_DCS_SET_DISPLAY_BRIGHTNESS:
+		// 12 bit DBV, high byte first; a single byte sets the low byte
+		if (len >= 2)
+			emu->dbv = ((par[0] << 8) | par[1]) & 0x0fff;
+		else if (len == 1)
+			emu->dbv = par[0];
+		break;
+	case 0x9C:
+		emu->key_9c = len >= 2 && par[0] == 0xA5 && par[1] == 0xA5;
+		return;
+	case 0xFD:
+		emu->key_fd = len >= 2 && par[0] == 0x5A && par[1] == 0x5A;
+		return;
+	default:
+		break;
+	}
+
+	if (!dcs && !(emu->key_9c && emu->key_fd)) {
+		icna3512_emu_violation(emu, "user register written while locked", cmd);
+		return;
+	}
+
+	if (cmd == 0x9F && len) {
+		if (par[0] >= ICNA3512_EMU_NUM_PAGES)
+			icna3512_emu_violation(emu, "page out of range", cmd);
+		emu->page = par[0] % ICNA3512_EMU_NUM_PAGES;
+	}
+
+	// DCS registers are not paged
+	reg = &emu->regs[dcs ? 0 : emu->page][cmd];
+	reg->len = min_t(size_t, len, ICNA3512_EMU_REG_LEN);
+	memcpy(reg->val, par, reg->len);
+}
+
+static size_t icna3512_emu_read(struct icna3512_emu *emu, u8 cmd, u8 *buf, size_t len)
+{
+	const struct icna3512_emu_reg *reg;
+	u8 val[ICNA3512_EMU_REG_LEN] = { };
+	size_t n;
+
+	switch (cmd) {
+	case MIPI_DCS_GET_DISPLAY_ID:
+		memcpy(val, id, sizeof(id));
+		n = sizeof(id);
+		break;
+	case 0xDA:
+	case 0xDB:
+	case 0xDC:
+		val[0] = id[cmd - 0xDA];
+		n = 1;
+		break;
+	case MIPI_DCS_GET_POWER_MODE:
+		if (emu->gpio_val[ICNA3512_EMU_GPIO_DCDC_EN])
+			val[0] |= BIT(7);	/* booster */
+		if (emu->idle)
+			val[0] |= MIPI_DCS_POWER_MODE_IDLE;
+		if (!emu->sleep)
+			val[0] |= MIPI_DCS_POWER_MODE_SLEEP;	/* set = sleep out */
+		val[0] |= MIPI_DCS_POWER_MODE_NORMAL;
+		if (emu->display_on)
+			val[0] |= MIPI_DCS_POWER_MODE_DISPLAY;
+		n = 1;
+		break;
+	case MIPI_DCS_GET_DISPLAY_BRIGHTNESS:
+		val[0] = emu->dbv >> 8;
+		val[1] = emu->dbv & 0xff;
+		n = 2;
+		break;
+	case MIPI_DCS_GET_CONTROL_DISPLAY:
+		reg = &emu->regs[0][MIPI_DCS_WRITE_CONTROL_DISPLAY];
+		val[0] = reg->len ? reg->val[0] : 0;
+		n = 1;
+		break;
+	default:
+		// read back what was last written to the register on this page
+		reg = &emu->regs[emu->page][cmd];
+		memcpy(val, reg->val, reg->len);
+		n = reg->len ? reg->len : 1;
+		break;
+	}
+
+	// the IC never returns more than the last max return packet size
+	n = min3(n, len, (size_t)emu->max_return);
+	memcpy(buf, val, n);
+
+	return n;
+}
+
+static u64 icna3512_emu_cost(const struct mipi_dsi_packet *packet, bool lp,
+			     size_t rx_len)
+{
+	size_t bytes = packet->size;
+	u64 cost;
+
+	// long packets carry a 2 byte checksum after the payload
+	if (packet->payload_length)
+		bytes += 2;
+
+	if (lp)
+		cost = lp_packet_ns + (u64)bytes * lp_byte_ns;
+	else
+		cost = hs_packet_ns + (u64)bytes * hs_byte_ns;
+
+	// responses always come back in LP, header and checksum included
+	if (rx_len)
+		cost += bta_ns + (u64)(rx_len + 6) * lp_byte_ns;
+
+	return cost;
+}
+
+static void icna3512_emu_spend(u64 ns)
+{
+	if (ns >= 10 * NSEC_PER_USEC)
+		fsleep(DIV_ROUND_UP_ULL(ns, NSEC_PER_USEC));
+	else
+		ndelay(ns);
+}
+
+static int icna3512_emu_host_attach(struct mipi_dsi_host *host,
+				    struct mipi_dsi_device *dsi)
+{
+	dev_info(host->dev, "%s attached: %u lanes, format %d, mode flags %#lx\n",
+		 dev_name(&dsi->dev), dsi->lanes, dsi->format, dsi->mode_flags);
+
+	return 0;
+}
+
+static int icna3512_emu_host_detach(struct mipi_dsi_host *host,
+				    struct mipi_dsi_device *dsi)
+{
+	return 0;
+}
+
+static ssize_t icna3512_emu_host_transfer(struct mipi_dsi_host *host,
+					  const struct mipi_dsi_msg *msg)
+{
+	struct icna3512_emu *emu = container_of(host, struct icna3512_emu, host);
+	bool lp = msg->flags & MIPI_DSI_MSG_USE_LPM;
+	const u8 *tx = msg->tx_buf;
+	struct mipi_dsi_packet packet;
+	ssize_t ret;
+	u64 cost;
+
+	ret = mipi_dsi_create_packet(&packet, msg);
+	if (ret < 0)
+		return ret;
+
+	mutex_lock(&emu->lock);
+	icna3512_emu_sync_pins(emu);
+
+	cost = icna3512_emu_cost(&packet, lp, msg->rx_len);
+	emu->stats.packets[lp]++;
+	emu->stats.bytes[lp] += packet.size;
+	emu->stats.link_ns += cost;
+
+	icna3512_emu_spend(cost);
+
+	// without power or in reset writes vanish and reads never come back
+	if (!icna3512_emu_alive(emu)) {
+		icna3512_emu_violation(emu, "packet while powered down or in reset",
+				       msg->tx_len ? tx[0] : 0);
+		ret = msg->rx_len ? -ETIMEDOUT : msg->tx_len;
+		goto unlock;
+	}
+
+	switch (msg->type) {
+	case MIPI_DSI_SET_MAXIMUM_RETURN_PACKET_SIZE:
+		emu->max_return = tx[0] | (tx[1] << 8);
+		ret = msg->tx_len;
+		break;
+	case MIPI_DSI_DCS_SHORT_WRITE:
+	case MIPI_DSI_DCS_SHORT_WRITE_PARAM:
+	case MIPI_DSI_DCS_LONG_WRITE:
+		icna3512_emu_write(emu, tx[0], tx + 1, msg->tx_len - 1);
+		ret = msg->tx_len;
+		break;
+	case MIPI_DSI_DCS_READ:
+		emu->stats.reads++;
+		ret = icna3512_emu_read(emu, tx[0], msg->rx_buf, msg->rx_len);
+		break;
+	default:
+		icna3512_emu_violation(emu, "unsupported data type", msg->type);
+		ret = -EINVAL;
+		break;
+	}
+
+unlock:
+	mutex_unlock(&emu->lock);
+
+	return ret;
+}
+
+static const struct mipi_dsi_host_ops icna3512_emu_host_ops = {
+	.attach = icna3512_emu_host_attach,
+	.detach = icna3512_emu_host_detach,
+	.transfer = icna3512_emu_host_transfer,
+};
+
+static int icna3512_emu_gpio_get_direction(struct gpio_chip *gc,
+					   unsigned int offset)
+{
+	return GPIO_LINE_DIRECTION_OUT;
+}
+
+static int icna3512_emu_gpio_get(struct gpio_chip *gc, unsigned int offset)
+{
+	struct icna3512_emu *emu = gpiochip_get_data(gc);
+
+	return emu->gpio_val[offset];
+}
+
+static void icna3512_emu_gpio_set(struct gpio_chip *gc, unsigned int offset,
+				  int value)
+{
+	struct icna3512_emu *emu = gpiochip_get_data(gc);
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->pin_lock, flags);
+
+	emu->gpio_val[offset] = value;
+
+	// nRESET is a physical level here, the lookup makes it active low
+	if (offset == ICNA3512_EMU_GPIO_RESET) {
+		if (!value) {
+			emu->in_reset = true;
+		} else if (emu->in_reset) {
+			emu->in_reset = false;
+			emu->reset_pending = true;
+		}
+	}
+
+	spin_unlock_irqrestore(&emu->pin_lock, flags);
+}
+
+static int icna3512_emu_gpio_direction_output(struct gpio_chip *gc,
+					      unsigned int offset, int value)
+{
+	icna3512_emu_gpio_set(gc, offset, value);
+
+	return 0;
+}
+
+static int icna3512_emu_reg_enable(struct regulator_dev *rdev)
+{
+	struct icna3512_emu *emu = rdev_get_drvdata(rdev);
+
+	mutex_lock(&emu->lock);
+	emu->supply_on[rdev_get_id(rdev)] = true;
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+
+static int icna3512_emu_reg_disable(struct regulator_dev *rdev)
+{
+	struct icna3512_emu *emu = rdev_get_drvdata(rdev);
+
+	mutex_lock(&emu->lock);
+	emu->supply_on[rdev_get_id(rdev)] = false;
+	icna3512_emu_reset(emu);
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+
+static int icna3512_emu_reg_is_enabled(struct regulator_dev *rdev)
+{
+	struct icna3512_emu *emu = rdev_get_drvdata(rdev);
+
+	return emu->supply_on[rdev_get_id(rdev)];
+}
+
+static const struct regulator_ops icna3512_emu_reg_ops = {
+	.enable = icna3512_emu_reg_enable,
+	.disable = icna3512_emu_reg_disable,
+	.is_enabled = icna3512_emu_reg_is_enabled,
+};
+
+static int icna3512_emu_state_show(struct seq_file *s, void *data)
+{
+	struct icna3512_emu *emu = s->private;
+
+	mutex_lock(&emu->lock);
+	icna3512_emu_sync_pins(emu);
+
+	seq_printf(s, "supplies:   vddp %d iovcc %d\n", emu->supply_on[0], emu->supply_on[1]);
+	seq_printf(s, "nreset:     %d\n", emu->gpio_val[ICNA3512_EMU_GPIO_RESET]);
+	seq_printf(s, "dcdc-en:    %d\n", emu->gpio_val[ICNA3512_EMU_GPIO_DCDC_EN]);
+	seq_printf(s, "sleep:      %d\n", emu->sleep);
+	seq_printf(s, "display on: %d\n", emu->display_on);
+	seq_printf(s, "idle:       %d\n", emu->idle);
+	seq_printf(s, "unlocked:   %d\n", emu->key_9c && emu->key_fd);
+	seq_printf(s, "page:       %02x\n", emu->page);
+	seq_printf(s, "dbv:        %03x\n", emu->dbv);
+	seq_printf(s, "frame rate: %02x\n", emu->regs[0][0x48].val[0]);
+	seq_printf(s, "id:         %02x %02x %02x\n", id[0], id[1], id[2]);
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(icna3512_emu_state);
+
+static int icna3512_emu_regs_show(struct seq_file *s, void *data)
+{
+	struct icna3512_emu *emu = s->private;
+	unsigned int page, cmd;
+
+	mutex_lock(&emu->lock);
+	icna3512_emu_sync_pins(emu);
+
+	for (page = 0; page < ICNA3512_EMU_NUM_PAGES; page++) {
+		for (cmd = 0; cmd < 256; cmd++) {
+			const struct icna3512_emu_reg *reg = &emu->regs[page][cmd];
+
+			if (!reg->len)
+				continue;
+
+			seq_printf(s, "%02x:%02x %*ph\n", page, cmd, reg->len, reg->val);
+		}
+	}
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(icna3512_emu_regs);
+
+static int icna3512_emu_stats_show(struct seq_file *s, void *data)
+{
+	struct icna3512_emu *emu = s->private;
+	struct icna3512_emu_stats *st = &emu->stats;
+
+	mutex_lock(&emu->lock);
+
+	seq_printf(s, "lp packets:  %llu\n", st->packets[1]);
+	seq_printf(s, "lp bytes:    %llu\n", st->bytes[1]);
+	seq_printf(s, "hs packets:  %llu\n", st->packets[0]);
+	seq_printf(s, "hs bytes:    %llu\n", st->bytes[0]);
+	seq_printf(s, "reads:       %llu\n", st->reads);
+	seq_printf(s, "link time:   %llu us\n", div_u64(st->link_ns, NSEC_PER_USEC));
+	seq_printf(s, "resets:      %llu\n", st->resets);
+	seq_printf(s, "violations:  %llu\n", st->violations);
+	if (st->violations)
+		seq_printf(s, "last:        %s\n", st->last_violation);
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+
+static int icna3512_emu_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, icna3512_emu_stats_show, inode->i_private);
+}
+
+static ssize_t icna3512_emu_stats_write(struct file *file, const char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	struct icna3512_emu *emu = file_inode(file)->i_private;
+
+	mutex_lock(&emu->lock);
+	memset(&emu->stats, 0, sizeof(emu->stats));
+	mutex_unlock(&emu->lock);
+
+	return count;
+}
+
+static const struct file_operations icna3512_emu_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = icna3512_emu_stats_open,
+	.read = seq_read,
+	.write = icna3512_emu_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int icna3512_emu_add_supplies(struct icna3512_emu *emu)
+{
+	struct regulator_config config = { };
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(icna3512_emu_supplies); i++) {
+		snprintf(emu->reg_name[i], sizeof(emu->reg_name[i]), "%s-%s",
+			 ICNA3512_EMU_NAME, icna3512_emu_supplies[i]);
+
+		emu->reg_desc[i].name = emu->reg_name[i];
+		emu->reg_desc[i].id = i;
+		emu->reg_desc[i].ops = &icna3512_emu_reg_ops;
+		emu->reg_desc[i].type = REGULATOR_VOLTAGE;
+		emu->reg_desc[i].owner = THIS_MODULE;
+
+		emu->reg_supply[i].supply = icna3512_emu_supplies[i];
+		emu->reg_supply[i].dev_name = ICNA3512_EMU_DSI_NAME;
+
+		emu->reg_init[i].constraints.valid_ops_mask = REGULATOR_CHANGE_STATUS;
+		emu->reg_init[i].num_consumer_supplies = 1;
+		emu->reg_init[i].consumer_supplies = &emu->reg_supply[i];
+
+		config.dev = emu->supply_dev;
+		config.init_data = &emu->reg_init[i];
+		config.driver_data = emu;
+
+		emu->rdev[i] = regulator_register(emu->supply_dev, &emu->reg_desc[i],
+						  &config);
+		if (IS_ERR(emu->rdev[i])) {
+			int ret = PTR_ERR(emu->rdev[i]);
+
+			while (i--)
+				regulator_unregister(emu->rdev[i]);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void icna3512_emu_del_supplies(struct icna3512_emu *emu)
+{
+	unsigned int i = ARRAY_SIZE(icna3512_emu_supplies);
+
+	while (i--)
+		regulator_unregister(emu->rdev[i]);
+}
+
+static int __init icna3512_emu_init(void)
+{
+	struct mipi_dsi_device_info info = {
+		.type = ICNA3512_EMU_NAME,
+		.channel = 0,
+	};
+	struct device_driver *drv;
+	struct icna3512_emu *emu;
+	int ret;
+
+	emu = kzalloc(sizeof(*emu), GFP_KERNEL);
+	if (!emu)
+		return -ENOMEM;
+
+	emu->regs = vzalloc(sizeof(*emu->regs) * ICNA3512_EMU_NUM_PAGES);
+	if (!emu->regs) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	spin_lock_init(&emu->pin_lock);
+	mutex_init(&emu->lock);
+	icna3512_emu_reset(emu);
+	emu->in_reset = true;
+
+	// the host device may only parent DSI devices, see mipi_dsi_host_unregister()
+	emu->supply_dev = root_device_register(ICNA3512_EMU_SUPPLY_NAME);
+	if (IS_ERR(emu->supply_dev)) {
+		ret = PTR_ERR(emu->supply_dev);
+		goto err_free_regs;
+	}
+
+	ret = icna3512_emu_add_supplies(emu);
+	if (ret)
+		goto err_supply_dev;
+
+	emu->gc.label = ICNA3512_EMU_SUPPLY_NAME;
+	emu->gc.parent = emu->supply_dev;
+	emu->gc.owner = THIS_MODULE;
+	emu->gc.base = -1;
+	emu->gc.ngpio = ICNA3512_EMU_NUM_GPIOS;
+	emu->gc.get_direction = icna3512_emu_gpio_get_direction;
+	emu->gc.direction_output = icna3512_emu_gpio_direction_output;
+	emu->gc.get = icna3512_emu_gpio_get;
+	emu->gc.set = icna3512_emu_gpio_set;
+
+	ret = gpiochip_add_data(&emu->gc, emu);
+	if (ret)
+		goto err_supplies;
+
+	emu->lookup = kzalloc(struct_size(emu->lookup, table, 3), GFP_KERNEL);
+	if (!emu->lookup) {
+		ret = -ENOMEM;
+		goto err_gpiochip;
+	}
+
+	// same polarity as the reset-gpios / dcdc-en-gpios of the overlays
+	emu->lookup->dev_id = ICNA3512_EMU_DSI_NAME;
+	emu->lookup->table[0] = (struct gpiod_lookup)
+		GPIO_LOOKUP(ICNA3512_EMU_SUPPLY_NAME, ICNA3512_EMU_GPIO_RESET,
+			    "reset", GPIO_ACTIVE_LOW);
+	emu->lookup->table[1] = (struct gpiod_lookup)
+		GPIO_LOOKUP(ICNA3512_EMU_SUPPLY_NAME, ICNA3512_EMU_GPIO_DCDC_EN,
+			    "dcdc-en", GPIO_ACTIVE_HIGH);
+	gpiod_add_lookup_table(emu->lookup);
+
+	emu->host_dev = root_device_register(ICNA3512_EMU_NAME);
+	if (IS_ERR(emu->host_dev)) {
+		ret = PTR_ERR(emu->host_dev);
+		goto err_lookup;
+	}
+
+	emu->host.dev = emu->host_dev;
+	emu->host.ops = &icna3512_emu_host_ops;
+
+	ret = mipi_dsi_host_register(&emu->host);
+	if (ret)
+		goto err_host_dev;
+
+	emu->dsi = mipi_dsi_device_register_full(&emu->host, &info);
+	if (IS_ERR(emu->dsi)) {
+		ret = PTR_ERR(emu->dsi);
+		goto err_host;
+	}
+
+	emu->debugfs = debugfs_create_dir(ICNA3512_EMU_NAME, NULL);
+	debugfs_create_file("state", 0444, emu->debugfs, emu, &icna3512_emu_state_fops);
+	debugfs_create_file("regs", 0444, emu->debugfs, emu, &icna3512_emu_regs_fops);
+	debugfs_create_file("stats", 0644, emu->debugfs, emu, &icna3512_emu_stats_fops);
+
+	icna3512_emu = emu;
+
+	request_module(ICNA3512_EMU_DRIVER_NAME);
+	drv = driver_find(ICNA3512_EMU_DRIVER_NAME, emu->dsi->dev.bus);
+	if (!drv)
+		dev_warn(emu->host_dev, "%s not loaded, nothing to emulate for\n",
+			 ICNA3512_EMU_DRIVER_NAME);
+	else if (device_driver_attach(drv, &emu->dsi->dev))
+		dev_warn(emu->host_dev, "failed to bind %s\n", ICNA3512_EMU_DRIVER_NAME);
+
+	return 0;
+
+err_host:
+	mipi_dsi_host_unregister(&emu->host);
+err_host_dev:
+	root_device_unregister(emu->host_dev);
+err_lookup:
+	gpiod_remove_lookup_table(emu->lookup);
+	kfree(emu->lookup);
+err_gpiochip:
+	gpiochip_remove(&emu->gc);
+err_supplies:
+	icna3512_emu_del_supplies(emu);
+err_supply_dev:
+	root_device_unregister(emu->supply_dev);
+err_free_regs:
+	vfree(emu->regs);
+err_free:
+	kfree(emu);
+
+	return ret;
+}
+module_init(icna3512_emu_init);
+
+static void __exit icna3512_emu_exit(void)
+{
+	struct icna3512_emu *emu = icna3512_emu;
+
+	debugfs_remove_recursive(emu->debugfs);
+
+	mipi_dsi_device_unregister(emu->dsi);
+	mipi_dsi_host_unregister(&emu->host);
+	root_device_unregister(emu->host_dev);
+
+	gpiod_remove_lookup_table(emu->lookup);
+	kfree(emu->lookup);
+	gpiochip_remove(&emu->gc);
+
+	icna3512_emu_del_supplies(emu);
+	root_device_unregister(emu->supply_dev);
+
+	vfree(emu->regs);
+	kfree(emu);
+}
+module_exit(icna3512_emu_exit);
+
+MODULE_AUTHOR("Frankie Yuen <frankie.yuen@me.com>");
+MODULE_DESCRIPTION("Chipone ICNA3512 panel emulator on a fake DSI host");
+MODULE_LICENSE("GPL v2");
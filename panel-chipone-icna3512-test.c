@@ -0,0 +1,1726 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit tests for the ICNA3512 panel driver.
+ *
+ * The driver is probed against a fake DSI host that records every packet,
+ * a two line GPIO chip standing in for reset / dcdc-en and two fake
+ * regulators for vddp / iovcc. All of them log into one timestamped event
+ * list, so the tests can check the exact command stream as well as the
+ * ordering and the delays between power, reset and DSI traffic.
+ *
+ * This file is included by panel-chipone-icna3512.c so the tests can reach
+ * the static functions. Build it into the module with
+ *
+ *	make KDIR=<kernel build dir> KUNIT=1
+ *
+ * against a kernel configured with the .kunitconfig fragment next to this
+ * file (e.g. an ARCH=um build), and the suite runs when the module loads.
+ */
+
+#include <kunit/test.h>
+
+#include <linux/gpio/driver.h>
+#include <linux/gpio/machine.h>
+#include <linux/regulator/driver.h>
+#include <linux/regulator/machine.h>
+#include <linux/spinlock.h>
+
+#define ICNA3512_TEST_HOST_NAME		"icna3512-kunit"
+#define ICNA3512_TEST_SUPPLY_NAME	"icna3512-kunit-supply"
+#define ICNA3512_TEST_DSI_NAME		ICNA3512_TEST_HOST_NAME ".0"
+#define ICNA3512_TEST_LINK_NAME		"icna3512-kunit-link1"
+#define ICNA3512_TEST_MAX_EVENTS	512
+
+enum icna3512_test_gpio {
+	ICNA3512_TEST_GPIO_RESET,
+	ICNA3512_TEST_GPIO_DCDC_EN,
+	ICNA3512_TEST_NUM_GPIOS,
+};
+
+enum icna3512_test_event_kind {
+	ICNA3512_TEST_EV_DSI,
+	ICNA3512_TEST_EV_GPIO,
+	ICNA3512_TEST_EV_REG,
+};
+
+struct icna3512_test_event {
+	enum icna3512_test_event_kind kind;
+	ktime_t ts;
+	unsigned int link;	/* DSI link the packet went out on */
+	unsigned int id;	/* DSI data type, GPIO line or regulator index */
+	int value;		/* DSI message flags, GPIO level or regulator state */
+	size_t len;
+	u8 data[32];
+};
+
+struct icna3512_test {
+	struct kunit *test;
+
+	struct device *host_dev;
+	struct device *supply_dev;
+	struct mipi_dsi_host host;
+	struct mipi_dsi_device *dsi;
+	struct icna3512_panel *icna3512;
+
+	/* second link, only set up by the dual-DSI tests */
+	struct device *link_dev;
+	struct mipi_dsi_host link_host;
+	struct mipi_dsi_device *link_dsi;
+
+	struct gpio_chip gc;
+	struct gpiod_lookup_table *lookup;
+	int gpio_val[ICNA3512_TEST_NUM_GPIOS];
+
+	char reg_name[ARRAY_SIZE(regulator_names)][32];
+	struct regulator_desc reg_desc[ARRAY_SIZE(regulator_names)];
+	struct regulator_consumer_supply reg_supply[ARRAY_SIZE(regulator_names)];
+	struct regulator_init_data reg_init[ARRAY_SIZE(regulator_names)];
+	bool reg_on[ARRAY_SIZE(regulator_names)];
+
+	/* fault injection */
+	int reg_fail;		/* regulator index + 1 whose enable fails */
+	u8 fail_cmd;		/* fail the fail_nth packet carrying this command */
+	unsigned int fail_nth;
+	bool id_fail;
+	u8 id[3];
+	u8 power_mode;		/* reply to get_power_mode, 0: no reply */
+
+	/* regulator_bulk_enable() enables the supplies from async workers */
+	spinlock_t ev_lock;
+	struct icna3512_test_event *ev;
+	unsigned int num_ev;
+};
+
+static void icna3512_test_log(struct icna3512_test *t,
+			      enum icna3512_test_event_kind kind,
+			      unsigned int link, unsigned int id, int value,
+			      const u8 *data, size_t len)
+{
+	struct icna3512_test_event *ev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&t->ev_lock, flags);
+
+	if (t->num_ev < ICNA3512_TEST_MAX_EVENTS) {
+		ev = &t->ev[t->num_ev++];
+		ev->kind = kind;
+		ev->ts = ktime_get();
+		ev->link = link;
+		ev->id = id;
+		ev->value = value;
+		ev->len = len;
+		memcpy(ev->data, data, min(len, sizeof(ev->data)));
+	}
+
+	spin_unlock_irqrestore(&t->ev_lock, flags);
+}
+
+static void icna3512_test_clear(struct icna3512_test *t)
+{
+	t->num_ev = 0;
+}
+
+/* Fake DSI host */
+
+static int icna3512_test_host_attach(struct mipi_dsi_host *host,
+				     struct mipi_dsi_device *dsi)
+{
+	return 0;
+}
+
+static int icna3512_test_host_detach(struct mipi_dsi_host *host,
+				     struct mipi_dsi_device *dsi)
+{
+	return 0;
+}
+
+static ssize_t icna3512_test_transfer(struct icna3512_test *t, unsigned int link,
+				      const struct mipi_dsi_msg *msg)
+{
+	const u8 *tx = msg->tx_buf;
+	u8 cmd = msg->tx_len ? tx[0] : 0;
+	size_t len;
+
+	if (t->fail_nth && cmd == t->fail_cmd && !--t->fail_nth)
+		return -EIO;
+
+	icna3512_test_log(t, ICNA3512_TEST_EV_DSI, link, msg->type, msg->flags,
+			  tx, msg->tx_len);
+
+	if (!msg->rx_len)
+		return msg->tx_len;
+
+	if (cmd == MIPI_DCS_GET_POWER_MODE && t->power_mode) {
+		*(u8 *)msg->rx_buf = t->power_mode;
+		return 1;
+	}
+
+	if (cmd != MIPI_DCS_GET_DISPLAY_ID || t->id_fail)
+		return -EIO;
+
+	len = min(msg->rx_len, sizeof(t->id));
+	memcpy(msg->rx_buf, t->id, len);
+
+	return len;
+}
+
+static ssize_t icna3512_test_host_transfer(struct mipi_dsi_host *host,
+					   const struct mipi_dsi_msg *msg)
+{
+	return icna3512_test_transfer(container_of(host, struct icna3512_test, host),
+				      0, msg);
+}
+
+static ssize_t icna3512_test_link_transfer(struct mipi_dsi_host *host,
+					   const struct mipi_dsi_msg *msg)
+{
+	return icna3512_test_transfer(container_of(host, struct icna3512_test, link_host),
+				      1, msg);
+}
+
+static const struct mipi_dsi_host_ops icna3512_test_host_ops = {
+	.attach = icna3512_test_host_attach,
+	.detach = icna3512_test_host_detach,
+	.transfer = icna3512_test_host_transfer,
+};
+
+static const struct mipi_dsi_host_ops icna3512_test_link_ops = {
+	.attach = icna3512_test_host_attach,
+	.detach = icna3512_test_host_detach,
+	.transfer = icna3512_test_link_transfer,
+};
+
+/* Fake reset / dcdc-en GPIOs */
+
+static int icna3512_test_gpio_get_direction(struct gpio_chip *gc,
+					    unsigned int offset)
+{
+	return GPIO_LINE_DIRECTION_OUT;
+}
+
+static int icna3512_test_gpio_get(struct gpio_chip *gc, unsigned int offset)
+{
+	struct icna3512_test *t = gpiochip_get_data(gc);
+
+	return t->gpio_val[offset];
+}
+
+static void icna3512_test_gpio_set(struct gpio_chip *gc, unsigned int offset,
+				   int value)
+{
+	struct icna3512_test *t = gpiochip_get_data(gc);
+
+	t->gpio_val[offset] = value;
+	icna3512_test_log(t, ICNA3512_TEST_EV_GPIO, 0, offset, value, NULL, 0);
+}
+
+static int icna3512_test_gpio_direction_output(struct gpio_chip *gc,
+					       unsigned int offset, int value)
+{
+	icna3512_test_gpio_set(gc, offset, value);
+
+	return 0;
+}
+
+/* Fake vddp / iovcc supplies */
+
+static int icna3512_test_reg_enable(struct regulator_dev *rdev)
+{
+	struct icna3512_test *t = rdev_get_drvdata(rdev);
+	int id = rdev_get_id(rdev);
+
+	if (t->reg_fail == id + 1)
+		return -EIO;
+
+	t->reg_on[id] = true;
+	icna3512_test_log(t, ICNA3512_TEST_EV_REG, 0, id, 1, NULL, 0);
+
+	return 0;
+}
+
+static int icna3512_test_reg_disable(struct regulator_dev *rdev)
+{
+	struct icna3512_test *t = rdev_get_drvdata(rdev);
+	int id = rdev_get_id(rdev);
+
+	t->reg_on[id] = false;
+	icna3512_test_log(t, ICNA3512_TEST_EV_REG, 0, id, 0, NULL, 0);
+
+	return 0;
+}
+
+static int icna3512_test_reg_is_enabled(struct regulator_dev *rdev)
+{
+	struct icna3512_test *t = rdev_get_drvdata(rdev);
+
+	return t->reg_on[rdev_get_id(rdev)];
+}
+
+static const struct regulator_ops icna3512_test_reg_ops = {
+	.enable = icna3512_test_reg_enable,
+	.disable = icna3512_test_reg_disable,
+	.is_enabled = icna3512_test_reg_is_enabled,
+};
+
+/* Teardown actions, run in reverse order of registration */
+
+static void icna3512_test_root_device_unregister(void *dev)
+{
+	root_device_unregister(dev);
+}
+
+static void icna3512_test_regulator_unregister(void *rdev)
+{
+	regulator_unregister(rdev);
+}
+
+static void icna3512_test_gpiochip_remove(void *gc)
+{
+	gpiochip_remove(gc);
+}
+
+static void icna3512_test_lookup_remove(void *table)
+{
+	gpiod_remove_lookup_table(table);
+}
+
+static void icna3512_test_host_unregister(void *host)
+{
+	mipi_dsi_host_unregister(host);
+}
+
+static void icna3512_test_dsi_unregister(void *dsi)
+{
+	mipi_dsi_device_unregister(dsi);
+}
+
+static void icna3512_test_panel_remove(void *dsi)
+{
+	struct icna3512_panel *icna3512 = mipi_dsi_get_drvdata(dsi);
+
+	icna3512_panel_unprepare(&icna3512->base);
+	icna3512_panel_remove(dsi);
+}
+
+/* power the panel down before the second link goes away under it */
+static void icna3512_test_link_remove(void *data)
+{
+	struct icna3512_test *t = data;
+
+	icna3512_panel_unprepare(&t->icna3512->base);
+	mipi_dsi_detach(t->link_dsi);
+	t->icna3512->dsi_sec = NULL;
+}
+
+static int icna3512_test_add_supplies(struct kunit *test, struct icna3512_test *t)
+{
+	struct regulator_config config = { };
+	struct regulator_dev *rdev;
+	unsigned int i;
+	int ret;
+
+	t->supply_dev = root_device_register(ICNA3512_TEST_SUPPLY_NAME);
+	if (IS_ERR(t->supply_dev))
+		return PTR_ERR(t->supply_dev);
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_root_device_unregister,
+					t->supply_dev);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < ARRAY_SIZE(regulator_names); i++) {
+		snprintf(t->reg_name[i], sizeof(t->reg_name[i]), "%s-%s",
+			 ICNA3512_TEST_HOST_NAME, regulator_names[i]);
+
+		t->reg_desc[i].name = t->reg_name[i];
+		t->reg_desc[i].id = i;
+		t->reg_desc[i].ops = &icna3512_test_reg_ops;
+		t->reg_desc[i].type = REGULATOR_VOLTAGE;
+		t->reg_desc[i].owner = THIS_MODULE;
+
+		t->reg_supply[i].supply = regulator_names[i];
+		t->reg_supply[i].dev_name = ICNA3512_TEST_DSI_NAME;
+
+		t->reg_init[i].constraints.valid_ops_mask = REGULATOR_CHANGE_STATUS;
+		t->reg_init[i].num_consumer_supplies = 1;
+		t->reg_init[i].consumer_supplies = &t->reg_supply[i];
+
+		config.dev = t->supply_dev;
+		config.init_data = &t->reg_init[i];
+		config.driver_data = t;
+
+		rdev = regulator_register(t->supply_dev, &t->reg_desc[i], &config);
+		if (IS_ERR(rdev))
+			return PTR_ERR(rdev);
+
+		ret = kunit_add_action_or_reset(test, icna3512_test_regulator_unregister,
+						rdev);
+		if (ret)
+			return ret;
+	}
+
+	t->gc.label = ICNA3512_TEST_SUPPLY_NAME;
+	t->gc.parent = t->supply_dev;
+	t->gc.owner = THIS_MODULE;
+	t->gc.base = -1;
+	t->gc.ngpio = ICNA3512_TEST_NUM_GPIOS;
+	t->gc.get_direction = icna3512_test_gpio_get_direction;
+	t->gc.direction_output = icna3512_test_gpio_direction_output;
+	t->gc.get = icna3512_test_gpio_get;
+	t->gc.set = icna3512_test_gpio_set;
+
+	ret = gpiochip_add_data(&t->gc, t);
+	if (ret)
+		return ret;
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_gpiochip_remove, &t->gc);
+	if (ret)
+		return ret;
+
+	t->lookup = kunit_kzalloc(test, struct_size(t->lookup, table, 3), GFP_KERNEL);
+	if (!t->lookup)
+		return -ENOMEM;
+
+	t->lookup->dev_id = ICNA3512_TEST_DSI_NAME;
+	t->lookup->table[0] = (struct gpiod_lookup)
+		GPIO_LOOKUP(ICNA3512_TEST_SUPPLY_NAME, ICNA3512_TEST_GPIO_RESET,
+			    "reset", GPIO_ACTIVE_HIGH);
+	t->lookup->table[1] = (struct gpiod_lookup)
+		GPIO_LOOKUP(ICNA3512_TEST_SUPPLY_NAME, ICNA3512_TEST_GPIO_DCDC_EN,
+			    "dcdc-en", GPIO_ACTIVE_HIGH);
+
+	gpiod_add_lookup_table(t->lookup);
+
+	return kunit_add_action_or_reset(test, icna3512_test_lookup_remove, t->lookup);
+}
+
+static int icna3512_test_init(struct kunit *test)
+{
+	struct mipi_dsi_device_info info = {
+		.type = ICNA3512_TEST_HOST_NAME,
+		.channel = 0,
+	};
+	struct icna3512_test *t;
+	int ret;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->ev = kunit_kcalloc(test, ICNA3512_TEST_MAX_EVENTS, sizeof(*t->ev),
+			      GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->ev);
+
+	spin_lock_init(&t->ev_lock);
+	t->test = test;
+	test->priv = t;
+
+	ret = icna3512_test_add_supplies(test, t);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	/* the host device must only parent DSI devices, see mipi_dsi_host_unregister() */
+	t->host_dev = root_device_register(ICNA3512_TEST_HOST_NAME);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->host_dev));
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_root_device_unregister,
+					t->host_dev);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->host.dev = t->host_dev;
+	t->host.ops = &icna3512_test_host_ops;
+
+	ret = mipi_dsi_host_register(&t->host);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_host_unregister, &t->host);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	/* named after the host so no driver binds, probe is called below */
+	t->dsi = mipi_dsi_device_register_full(&t->host, &info);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dsi));
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_dsi_unregister, t->dsi);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	ret = icna3512_panel_probe(t->dsi);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_panel_remove, t->dsi);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->icna3512 = mipi_dsi_get_drvdata(t->dsi);
+
+	return 0;
+}
+
+/*
+ * Hook a second fake host up as the dual-DSI link, the way
+ * icna3512_panel_get_link() would from port@1 of the panel node.
+ */
+static void icna3512_test_add_link(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct mipi_dsi_device_info info = {
+		.type = ICNA3512_TEST_LINK_NAME,
+		.channel = 0,
+	};
+	int ret;
+
+	t->link_dev = root_device_register(ICNA3512_TEST_LINK_NAME);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->link_dev));
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_root_device_unregister,
+					t->link_dev);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->link_host.dev = t->link_dev;
+	t->link_host.ops = &icna3512_test_link_ops;
+
+	ret = mipi_dsi_host_register(&t->link_host);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_host_unregister,
+					&t->link_host);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->link_dsi = mipi_dsi_device_register_full(&t->link_host, &info);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->link_dsi));
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_dsi_unregister,
+					t->link_dsi);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->link_dsi->lanes = t->dsi->lanes;
+	t->link_dsi->format = t->dsi->format;
+	t->link_dsi->mode_flags = t->dsi->mode_flags;
+
+	ret = mipi_dsi_attach(t->link_dsi);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+
+	t->icna3512->dsi_sec = t->link_dsi;
+
+	ret = kunit_add_action_or_reset(test, icna3512_test_link_remove, t);
+	KUNIT_ASSERT_EQ(test, ret, 0);
+}
+
+/* Helpers */
+
+static struct icna3512_test_event *
+icna3512_test_next(struct icna3512_test *t, unsigned int *pos,
+		   enum icna3512_test_event_kind kind)
+{
+	while (*pos < t->num_ev) {
+		struct icna3512_test_event *ev = &t->ev[(*pos)++];
+
+		if (ev->kind == kind)
+			return ev;
+	}
+
+	return NULL;
+}
+
+static int icna3512_test_find(struct icna3512_test *t, unsigned int from,
+			      enum icna3512_test_event_kind kind,
+			      unsigned int id, int value)
+{
+	unsigned int i;
+
+	for (i = from; i < t->num_ev; i++)
+		if (t->ev[i].kind == kind && t->ev[i].id == id &&
+		    t->ev[i].value == value)
+			return i;
+
+	return -1;
+}
+
+/* index of the first DSI packet of the given type (0: any) and command */
+static int icna3512_test_find_dsi(struct icna3512_test *t, unsigned int from,
+				  u8 type, u8 cmd)
+{
+	unsigned int i;
+
+	for (i = from; i < t->num_ev; i++)
+		if (t->ev[i].kind == ICNA3512_TEST_EV_DSI && t->ev[i].len &&
+		    (!type || t->ev[i].id == type) && t->ev[i].data[0] == cmd)
+			return i;
+
+	return -1;
+}
+
+/* index of the first DSI packet on a link carrying the given command */
+static int icna3512_test_find_link(struct icna3512_test *t, unsigned int link,
+				   u8 cmd)
+{
+	unsigned int i;
+
+	for (i = 0; i < t->num_ev; i++)
+		if (t->ev[i].kind == ICNA3512_TEST_EV_DSI && t->ev[i].len &&
+		    t->ev[i].link == link && t->ev[i].data[0] == cmd)
+			return i;
+
+	return -1;
+}
+
+static unsigned int icna3512_test_count(struct icna3512_test *t,
+					enum icna3512_test_event_kind kind)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < t->num_ev; i++)
+		n += t->ev[i].kind == kind;
+
+	return n;
+}
+
+/*
+ * Match the DSI packets from *pos against a sequence in the driver's packed
+ * format. The delay byte is checked as the minimum gap to the next event.
+ */
+static void icna3512_test_expect_seq(struct kunit *test, unsigned int *pos,
+				     const u8 *seq, size_t len)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_test_event *ev;
+	size_t i = 0;
+
+	while (i + ICNA3512_SEQ_HDR_LEN <= len) {
+		u8 delay = seq[i + 1];
+		u8 count = seq[i + 2];
+
+		ev = icna3512_test_next(t, pos, ICNA3512_TEST_EV_DSI);
+		KUNIT_ASSERT_NOT_NULL_MSG(test, ev, "stream ends at offset %zu", i);
+
+		KUNIT_EXPECT_EQ_MSG(test, ev->id, seq[i], "type at offset %zu", i);
+		KUNIT_EXPECT_EQ_MSG(test, ev->len, count, "length at offset %zu", i);
+		KUNIT_EXPECT_MEMEQ_MSG(test, ev->data, &seq[i + ICNA3512_SEQ_HDR_LEN],
+				       min_t(size_t, count, sizeof(ev->data)),
+				       "payload at offset %zu", i);
+
+		if (delay && *pos < t->num_ev)
+			KUNIT_EXPECT_GE_MSG(test,
+					    ktime_ms_delta(t->ev[*pos].ts, ev->ts),
+					    (s64)delay, "delay at offset %zu", i);
+
+		i += ICNA3512_SEQ_HDR_LEN + count;
+	}
+}
+
+static void icna3512_test_expect_gamma(struct kunit *test, unsigned int *pos,
+				       const struct icna3512_gamma_set *gamma)
+{
+	icna3512_test_expect_seq(test, pos, icna3512_gamma_begin,
+				 sizeof(icna3512_gamma_begin));
+	icna3512_test_expect_seq(test, pos, gamma->seq, gamma->len);
+	icna3512_test_expect_seq(test, pos, icna3512_gamma_end,
+				 sizeof(icna3512_gamma_end));
+}
+
+static void icna3512_test_expect_end(struct kunit *test, unsigned int pos)
+{
+	struct icna3512_test *t = test->priv;
+
+	KUNIT_EXPECT_NULL(test, icna3512_test_next(t, &pos, ICNA3512_TEST_EV_DSI));
+}
+
+static int icna3512_test_prepare(struct icna3512_test *t)
+{
+	return icna3512_panel_prepare(&t->icna3512->base);
+}
+
+static const u8 icna3512_test_id_read[] = {
+	0x37, 0x00, 0x02, 0x03,		/* max return packet size */
+		0x00,
+	0x06, 0x00, 0x01, 0x04,		/* read display ID */
+};
+
+static const u8 icna3512_test_dxq7d0023_head[] = {
+	0x39, 0x00, 0x03, 0x9C,
+		0xA5, 0xA5,
+	0x39, 0x00, 0x03, 0xFD,
+		0x5A, 0x5A,
+	0x15, 0x00, 0x02, 0x53,
+		0xE0,
+	0x39, 0x00, 0x03, 0x51,
+		0x00, 0x00,
+	0x15, 0x00, 0x02, 0x35,
+		0x00,
+	0x15, 0x00, 0x02, 0x9F,		/* PWM profile of slot 0 */
+		0x07,
+	0x39, 0x00, 0x08, 0xB2,
+		0x04, 0x18, 0x08, 0x0C, 0x04, 0x00, 0xC4,
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0x48,
+		0x03,
+};
+
+static const u8 icna3512_test_dxq7d0023_tail[] = {
+	0x05, 0x78, 0x01, 0x11,
+	0x39, 0x00, 0x03, 0x51,
+		0x05, 0x55,
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0xCE,
+		0x22,
+	0x15, 0x00, 0x02, 0x9F,
+		0x01,
+	0x15, 0x00, 0x02, 0xC5,
+		0x01,
+	0x05, 0x00, 0x01, 0x29,
+	0x05, 0x00, 0x01, 0x29,		/* icna3512_panel_on() */
+};
+
+static const u8 icna3512_test_g1700fh101gg_head[] = {
+	0x39, 0x00, 0x03, 0x9C,
+		0xA5, 0xA5,
+	0x39, 0x00, 0x03, 0xFD,
+		0x5A, 0x5A,
+	0x15, 0x00, 0x02, 0x53,
+		0xE0,
+	0x39, 0x00, 0x03, 0x51,
+		0x00, 0x00,
+	0x05, 0x00, 0x01, 0x35,
+	0x15, 0x00, 0x02, 0x9F,
+		0x07,
+	0x39, 0x00, 0x08, 0xB2,
+		0x04, 0x18, 0x08, 0x0C, 0x04, 0x00, 0xC4,
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0x48,
+		0x03,
+};
+
+static const u8 icna3512_test_g1700fh101gg_tail[] = {
+	0x05, 0x78, 0x01, 0x11,
+	0x39, 0x00, 0x03, 0x51,
+		0x0D, 0xBB,
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0xCE,
+		0x22,
+	0x15, 0x00, 0x02, 0x9F,		/* DSC off */
+		0x01,
+	0x15, 0x00, 0x02, 0xC5,
+		0x01,
+	0x05, 0x00, 0x01, 0x29,
+	0x05, 0x00, 0x01, 0x29,
+};
+
+static const u8 icna3512_test_off[] = {
+	0x05, 0x00, 0x01, 0x28,
+	0x05, 0x64, 0x01, 0x10,
+};
+
+/* Tests */
+
+static void icna3512_test_probe_quiet(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	/* probe must not touch the panel, the ID is read on first prepare */
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_DSI), 0);
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_REG), 0);
+	KUNIT_EXPECT_EQ(test, t->gpio_val[ICNA3512_TEST_GPIO_RESET], 1);
+	KUNIT_EXPECT_EQ(test, t->gpio_val[ICNA3512_TEST_GPIO_DCDC_EN], 0);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->id_read);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->desc, &dxq7d0023_desc);
+}
+
+static void icna3512_test_prepare_stream(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	unsigned int pos = 0;
+
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	icna3512_test_expect_seq(test, &pos, icna3512_test_id_read,
+				 sizeof(icna3512_test_id_read));
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_head,
+				 sizeof(icna3512_test_dxq7d0023_head));
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_60hz);
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_tail,
+				 sizeof(icna3512_test_dxq7d0023_tail));
+	icna3512_test_expect_end(test, pos);
+
+	KUNIT_EXPECT_TRUE(test, t->icna3512->prepared);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->gamma, &icna3512_gamma_60hz);
+}
+
+static void icna3512_test_prepare_staged(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	const u8 *head = icna3512_test_dxq7d0023_head;
+	unsigned int pos = 0;
+
+	t->icna3512->staged = true;
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_ASSERT_EQ(test, icna3512_panel_wait_tables(t->icna3512), 0);
+
+	/* PWM profile and gamma set follow DISP ON instead of leading SLP OUT */
+	icna3512_test_expect_seq(test, &pos, icna3512_test_id_read,
+				 sizeof(icna3512_test_id_read));
+	icna3512_test_expect_seq(test, &pos, head, 28);
+	icna3512_test_expect_seq(test, &pos, head + 44, 10);	/* 9F 0F, R48 */
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_tail,
+				 sizeof(icna3512_test_dxq7d0023_tail));
+	icna3512_test_expect_seq(test, &pos, head + 28, 21);
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_60hz);
+	icna3512_test_expect_end(test, pos);
+
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->gamma, &icna3512_gamma_60hz);
+	KUNIT_EXPECT_NOT_NULL(test, t->icna3512->pwm_live[0]);
+	KUNIT_EXPECT_GE(test, ktime_compare(t->icna3512->tables_ts,
+			t->icna3512->stage_ts[ICNA3512_STAGE_DISPON]), 0);
+
+	/* nothing left to stream on a panel that is already done */
+	icna3512_panel_unprepare(&t->icna3512->base);
+	KUNIT_EXPECT_EQ(test, icna3512_panel_wait_tables(t->icna3512), 0);
+}
+
+static void icna3512_test_prepare_lpm(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	int begin, end, i;
+
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	/*
+	 * PWM profile, R48 and the gamma set go out in HS, from the first 9F
+	 * to the final FF of the gamma set
+	 */
+	begin = icna3512_test_find_dsi(t, 0, 0, 0x9F);
+	end = begin;
+	while ((i = icna3512_test_find_dsi(t, end + 1, 0, 0xFF)) >= 0)
+		end = i;
+	KUNIT_ASSERT_GE(test, begin, 0);
+	KUNIT_ASSERT_GT(test, end, begin);
+
+	for (i = 0; i < t->num_ev; i++) {
+		if (t->ev[i].kind != ICNA3512_TEST_EV_DSI)
+			continue;
+		if (i >= begin && i <= end)
+			KUNIT_EXPECT_FALSE_MSG(test, t->ev[i].value & MIPI_DSI_MSG_USE_LPM,
+					       "gamma packet %d sent in LP", i);
+		else
+			KUNIT_EXPECT_TRUE_MSG(test, t->ev[i].value & MIPI_DSI_MSG_USE_LPM,
+					      "packet %d sent in HS", i);
+	}
+}
+
+static void icna3512_test_prepare_power_sequence(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	static const int reset_levels[] = { 1, 0, 1, 0 };
+	static const s64 reset_hold_us[] = { 10000, 3000, 7000, 15000 };
+	struct icna3512_test_event *ev, *prev = NULL;
+	int vddp, iovcc, dcdc;
+	unsigned int pos, i;
+
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	vddp = icna3512_test_find(t, 0, ICNA3512_TEST_EV_REG, 0, 1);
+	iovcc = icna3512_test_find(t, 0, ICNA3512_TEST_EV_REG, 1, 1);
+	dcdc = icna3512_test_find(t, 0, ICNA3512_TEST_EV_GPIO,
+				  ICNA3512_TEST_GPIO_DCDC_EN, 1);
+	KUNIT_ASSERT_GE(test, vddp, 0);
+	KUNIT_ASSERT_GE(test, iovcc, 0);
+	KUNIT_ASSERT_GE(test, dcdc, 0);
+
+	/* both rails up before the DC-DC, DC-DC before the reset pulse */
+	KUNIT_EXPECT_LT(test, vddp, dcdc);
+	KUNIT_EXPECT_LT(test, iovcc, dcdc);
+
+	pos = dcdc + 1;
+	for (i = 0; i < ARRAY_SIZE(reset_levels); i++) {
+		ev = icna3512_test_next(t, &pos, ICNA3512_TEST_EV_GPIO);
+		KUNIT_ASSERT_NOT_NULL(test, ev);
+		KUNIT_EXPECT_EQ(test, ev->id, ICNA3512_TEST_GPIO_RESET);
+		KUNIT_EXPECT_EQ(test, ev->value, reset_levels[i]);
+
+		if (prev)
+			KUNIT_EXPECT_GE_MSG(test, ktime_us_delta(ev->ts, prev->ts),
+					    reset_hold_us[i - 1],
+					    "reset step %u released early", i - 1);
+		prev = ev;
+	}
+
+	/* no DSI traffic until the reset pulse has settled */
+	pos = 0;
+	ev = icna3512_test_next(t, &pos, ICNA3512_TEST_EV_DSI);
+	KUNIT_ASSERT_NOT_NULL(test, ev);
+	KUNIT_EXPECT_TRUE(test, ev > prev);
+	KUNIT_EXPECT_GE(test, ktime_us_delta(ev->ts, prev->ts),
+			reset_hold_us[ARRAY_SIZE(reset_hold_us) - 1]);
+}
+
+static void icna3512_test_prepare_stages(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	const ktime_t *ts = t->icna3512->stage_ts;
+	unsigned int i;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	for (i = 1; i < ICNA3512_NUM_STAGES; i++)
+		KUNIT_EXPECT_GE_MSG(test, ktime_to_ns(ts[i]), ktime_to_ns(ts[i - 1]),
+				    "stage %u", i);
+
+	KUNIT_EXPECT_GE(test, ktime_ms_delta(ts[ICNA3512_STAGE_SLPOUT],
+					     ts[ICNA3512_STAGE_INIT]), 120);
+	KUNIT_EXPECT_GE(test, ktime_ms_delta(ts[ICNA3512_STAGE_RESET],
+					     ts[ICNA3512_STAGE_REGULATOR]), 35);
+}
+
+static void icna3512_test_prepare_twice(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+}
+
+static void icna3512_test_expect_powered_off(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(t->reg_on); i++)
+		KUNIT_EXPECT_FALSE(test, t->reg_on[i]);
+	KUNIT_EXPECT_EQ(test, t->gpio_val[ICNA3512_TEST_GPIO_RESET], 1);
+	KUNIT_EXPECT_EQ(test, t->gpio_val[ICNA3512_TEST_GPIO_DCDC_EN], 0);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->prepared);
+	KUNIT_EXPECT_NULL(test, t->icna3512->gamma);
+}
+
+static void icna3512_test_prepare_regulator_error(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	t->reg_fail = 2;
+	icna3512_test_clear(t);
+
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), -EIO);
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_DSI), 0);
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_GPIO), 0);
+	icna3512_test_expect_powered_off(test);
+}
+
+static void icna3512_test_prepare_init_error(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	unsigned int pos;
+
+	t->fail_cmd = MIPI_DCS_EXIT_SLEEP_MODE;
+	t->fail_nth = 1;
+	icna3512_test_clear(t);
+
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), -EIO);
+	KUNIT_EXPECT_EQ(test, icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_SET_DISPLAY_ON), -1);
+	icna3512_test_expect_powered_off(test);
+
+	/* the panel was reset, so the retry has to resend the gamma set */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_head,
+				 sizeof(icna3512_test_dxq7d0023_head));
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_60hz);
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_tail,
+				 sizeof(icna3512_test_dxq7d0023_tail));
+	icna3512_test_expect_end(test, pos);
+}
+
+static void icna3512_test_prepare_on_error(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	/* the second DISP ON is the one from icna3512_panel_on() */
+	t->fail_cmd = MIPI_DCS_SET_DISPLAY_ON;
+	t->fail_nth = 2;
+
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), -EIO);
+	icna3512_test_expect_powered_off(test);
+}
+
+static void icna3512_test_prepare_benching(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct drm_panel *panel = &t->icna3512->base;
+
+	/* while the power bench cycles the panel, DRM stays out */
+	t->icna3512->benching = true;
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), -EBUSY);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+
+	KUNIT_ASSERT_EQ(test, __icna3512_panel_prepare(panel, true), 0);
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_panel_unprepare(panel), 0);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+	KUNIT_EXPECT_TRUE(test, t->icna3512->prepared);
+
+	KUNIT_EXPECT_EQ(test, __icna3512_panel_unprepare(panel, true), 0);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->prepared);
+	t->icna3512->benching = false;
+}
+
+static void icna3512_test_unprepare_sequence(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	unsigned int pos = 0;
+	int off, reset, dcdc;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	icna3512_test_clear(t);
+
+	KUNIT_EXPECT_EQ(test, icna3512_panel_unprepare(&t->icna3512->base), 0);
+
+	icna3512_test_expect_seq(test, &pos, icna3512_test_off,
+				 sizeof(icna3512_test_off));
+	icna3512_test_expect_end(test, pos);
+
+	/* rails drop after SLP IN has settled, then reset and DC-DC */
+	off = icna3512_test_find(t, 0, ICNA3512_TEST_EV_REG, 0, 0);
+	reset = icna3512_test_find(t, 0, ICNA3512_TEST_EV_GPIO,
+				   ICNA3512_TEST_GPIO_RESET, 1);
+	dcdc = icna3512_test_find(t, 0, ICNA3512_TEST_EV_GPIO,
+				  ICNA3512_TEST_GPIO_DCDC_EN, 0);
+	KUNIT_ASSERT_GE(test, off, (int)pos);
+	KUNIT_EXPECT_LT(test, off, reset);
+	KUNIT_EXPECT_LT(test, reset, dcdc);
+
+	icna3512_test_expect_powered_off(test);
+}
+
+static void icna3512_test_id_selects_profile(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	unsigned int pos = 0;
+
+	t->id[1] = 0x01;
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	/* the commit reading the ID keeps the mode table it was set up with */
+	KUNIT_EXPECT_TRUE(test, t->icna3512->id_valid);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->desc, &dxq7d0023_desc);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->id_desc, &g1700fh101gg_desc);
+
+	icna3512_test_expect_seq(test, &pos, icna3512_test_id_read,
+				 sizeof(icna3512_test_id_read));
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_head,
+				 sizeof(icna3512_test_dxq7d0023_head));
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_60hz);
+	icna3512_test_expect_seq(test, &pos, icna3512_test_dxq7d0023_tail,
+				 sizeof(icna3512_test_dxq7d0023_tail));
+	icna3512_test_expect_end(test, pos);
+
+	/* the switch waits for the panel to go off */
+	KUNIT_ASSERT_EQ(test, icna3512_panel_unprepare(&t->icna3512->base), 0);
+	flush_work(&t->icna3512->desc_work);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->desc, &g1700fh101gg_desc);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->mode, &g1700fh101gg_modes[0]);
+	KUNIT_EXPECT_NULL(test, t->icna3512->id_desc);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->relinking);
+
+	/* the next power on runs the lot's init, the ID is only read once */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, icna3512_test_g1700fh101gg_head,
+				 sizeof(icna3512_test_g1700fh101gg_head));
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_60hz);
+	icna3512_test_expect_seq(test, &pos, icna3512_test_g1700fh101gg_tail,
+				 sizeof(icna3512_test_g1700fh101gg_tail));
+	icna3512_test_expect_end(test, pos);
+	KUNIT_EXPECT_EQ(test, icna3512_test_find_dsi(t, 0, MIPI_DSI_DCS_READ,
+						     MIPI_DCS_GET_DISPLAY_ID), -1);
+}
+
+static void icna3512_test_id_fixed_profile(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	/* a lot specific compatible wins over the ID */
+	t->icna3512->desc_fixed = true;
+	t->id[1] = 0x01;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_TRUE(test, t->icna3512->id_valid);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->desc, &dxq7d0023_desc);
+	KUNIT_EXPECT_NULL(test, t->icna3512->id_desc);
+}
+
+static void icna3512_test_id_read_error(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+
+	t->id_fail = true;
+
+	KUNIT_EXPECT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_TRUE(test, t->icna3512->id_read);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->id_valid);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->desc, &dxq7d0023_desc);
+}
+
+static void icna3512_test_rate_preference(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	const struct icna3512_mode *modes = icna3512->desc->modes;
+	static const u8 r48_120hz[] = {
+		0x15, 0x00, 0x02, 0x9F,		/* 10P at the default DBV */
+			0x07,
+		0x39, 0x00, 0x08, 0xB5,
+			0x04, 0x0A, 0x08, 0x0A, 0x04, 0x00, 0xC4,
+		0x15, 0x00, 0x02, 0x9F,
+			0x0F,
+		0x15, 0x00, 0x02, 0x48,
+			0x33,
+	};
+	unsigned int pos;
+	int pwm;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	/* a rate asked for on a running panel only moves the preferred mode */
+	icna3512_test_clear(t);
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_RATE, 120);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->mode, &modes[0]);
+	KUNIT_EXPECT_EQ(test, icna3512->req_hz, 120);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512_pick_mode(icna3512, icna3512->req_hz),
+			    &modes[1]);
+
+	/* a power on outside a commit takes it, R48 and gamma set together */
+	KUNIT_ASSERT_EQ(test, icna3512_panel_unprepare(&icna3512->base), 0);
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->mode, &modes[1]);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->gamma, &icna3512_gamma_120hz);
+
+	pwm = icna3512_test_find_dsi(t, 0, 0, 0xB5);
+	KUNIT_ASSERT_GT(test, pwm, 0);
+	pos = pwm - 1;
+	icna3512_test_expect_seq(test, &pos, r48_120hz, sizeof(r48_120hz));
+	icna3512_test_expect_gamma(test, &pos, &icna3512_gamma_120hz);
+}
+
+static void icna3512_test_drm_mode(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	const struct icna3512_mode *modes = icna3512->desc->modes;
+	struct drm_connector_state *conn_state;
+	struct drm_connector *connector;
+	struct drm_crtc_state *crtc_state;
+	struct drm_crtc *crtc;
+	int r48;
+
+	connector = kunit_kzalloc(test, sizeof(*connector), GFP_KERNEL);
+	conn_state = kunit_kzalloc(test, sizeof(*conn_state), GFP_KERNEL);
+	crtc = kunit_kzalloc(test, sizeof(*crtc), GFP_KERNEL);
+	crtc_state = kunit_kzalloc(test, sizeof(*crtc_state), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, connector);
+	KUNIT_ASSERT_NOT_NULL(test, conn_state);
+	KUNIT_ASSERT_NOT_NULL(test, crtc);
+	KUNIT_ASSERT_NOT_NULL(test, crtc_state);
+
+	/* KMS scans out 120Hz, a sysfs preference for 144Hz loses */
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_RATE, 144);
+	flush_work(&icna3512->cmd_work);
+	flush_work(&icna3512->hotplug_work);
+	crtc_state->mode = modes[1].mode;
+	crtc->state = crtc_state;
+	conn_state->crtc = crtc;
+	connector->state = conn_state;
+	icna3512->connector = connector;
+
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->mode, &modes[1]);
+
+	r48 = icna3512_test_find_dsi(t, 0, 0, 0x48);
+	KUNIT_ASSERT_GE(test, r48, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[r48].data[1], modes[1].frame_rate);
+}
+
+static void icna3512_test_pwm_bands(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	struct backlight_device *bl = icna3512->backlight;
+	const struct icna3512_mode *modes = icna3512->desc->modes;
+	static const u8 bright_120hz[] = {
+		0x15, 0x00, 0x02, 0x9F,
+			0x07,
+		0x39, 0x00, 0x08, 0xB5,		/* 10P above 0x0516 */
+			0x04, 0x0A, 0x08, 0x0A, 0x04, 0x00, 0xC4,
+		0x15, 0x00, 0x02, 0x9F,
+			0x0F,
+		0x39, 0x00, 0x03, 0x51,		/* 12 bit, high byte first */
+			0x0F, 0xFF,
+	};
+	static const u8 dbv_in_band[] = {
+		0x39, 0x00, 0x03, 0x51,
+			0x0A, 0x05,
+	};
+	unsigned int pos;
+	int r48, pwm;
+
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_RATE, 120);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_ASSERT_PTR_EQ(test, icna3512->mode, &modes[1]);
+
+	/* crossing into the high band sends the 10P profile with the DBV */
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(bl, 0x0100), 0);
+	flush_work(&icna3512->cmd_work);
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(bl, bl->props.max_brightness), 0);
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, bright_120hz, sizeof(bright_120hz));
+	icna3512_test_expect_end(test, pos);
+
+	/* staying in the band is the DBV alone */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(bl, 0x0A05), 0);
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dbv_in_band, sizeof(dbv_in_band));
+	icna3512_test_expect_end(test, pos);
+
+	/* powered on again in the low band, the profile folds in ahead of R48 */
+	KUNIT_ASSERT_EQ(test, icna3512_panel_unprepare(&icna3512->base), 0);
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(bl, 0x0100), 0);
+	flush_work(&icna3512->cmd_work);
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	pwm = icna3512_test_find_dsi(t, 0, 0, 0xB5);
+	r48 = icna3512_test_find_dsi(t, 0, 0, 0x48);
+	KUNIT_ASSERT_GE(test, pwm, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[pwm].data[2], 0x18);
+	KUNIT_EXPECT_EQ(test, r48, pwm + 2);
+	KUNIT_EXPECT_FALSE(test, t->ev[r48].value & MIPI_DSI_MSG_USE_LPM);
+}
+
+static unsigned int icna3512_test_offered(struct icna3512_panel *icna3512)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < icna3512->desc->num_modes; i++)
+		n += icna3512_mode_offered(icna3512, &icna3512->desc->modes[i]);
+
+	return n;
+}
+
+static void icna3512_test_cooling(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	const struct icna3512_mode *modes = icna3512->desc->modes;
+	struct thermal_cooling_device *cdev;
+	unsigned long state;
+	static const u8 dbv_full[] = {
+		0x39, 0x00, 0x03, 0x51,
+			0x00, 0xC8,
+	};
+	static const u8 dbv_60pct[] = {
+		0x39, 0x00, 0x03, 0x51,
+			0x00, 0x78,
+	};
+	unsigned int pos;
+
+	cdev = kunit_kzalloc(test, sizeof(*cdev), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, cdev);
+	cdev->devdata = icna3512;
+
+	KUNIT_ASSERT_EQ(test, icna3512_cooling_ops.get_max_state(cdev, &state), 0);
+	KUNIT_EXPECT_EQ(test, state, ARRAY_SIZE(icna3512_cooling) - 1);
+
+	mutex_lock(&icna3512->lock);
+	KUNIT_ASSERT_EQ(test, icna3512_panel_set_rate(icna3512, 120), 0);
+	mutex_unlock(&icna3512->lock);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(icna3512->backlight, 200), 0);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_EXPECT_EQ(test, icna3512_test_offered(icna3512), icna3512->desc->num_modes);
+
+	/* the 60Hz cap only prunes what KMS is offered, the scanout rate stays */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_cooling_ops.set_cur_state(cdev, 3), 0);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->mode, &modes[1]);
+	KUNIT_EXPECT_EQ(test, icna3512_test_offered(icna3512), 1);
+	KUNIT_EXPECT_TRUE(test, icna3512_mode_offered(icna3512, &modes[0]));
+	KUNIT_EXPECT_PTR_EQ(test, icna3512_pick_mode(icna3512, icna3512->req_hz),
+			    &modes[0]);
+
+	/* deeper states only scale the DBV */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_cooling_ops.set_cur_state(cdev, 5), 0);
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dbv_60pct, sizeof(dbv_60pct));
+	icna3512_test_expect_end(test, pos);
+
+	/* the backlight is scaled too while throttled */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, backlight_device_set_brightness(icna3512->backlight, 200), 0);
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dbv_60pct, sizeof(dbv_60pct));
+	icna3512_test_expect_end(test, pos);
+
+	/* lifting the cap restores the DBV and offers the asked for rate again */
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_cooling_ops.set_cur_state(cdev, 0), 0);
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dbv_full, sizeof(dbv_full));
+	icna3512_test_expect_end(test, pos);
+	KUNIT_EXPECT_EQ(test, icna3512_test_offered(icna3512), icna3512->desc->num_modes);
+	KUNIT_EXPECT_PTR_EQ(test, icna3512_pick_mode(icna3512, icna3512->req_hz),
+			    &modes[1]);
+	KUNIT_ASSERT_EQ(test, icna3512_cooling_ops.get_cur_state(cdev, &state), 0);
+	KUNIT_EXPECT_EQ(test, state, 0);
+
+	KUNIT_EXPECT_EQ(test, icna3512_cooling_ops.set_cur_state(cdev, state + 100), -EINVAL);
+}
+
+static void icna3512_test_queue(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	static const u8 dbv[] = {
+		0x39, 0x00, 0x03, 0x51,
+			0x00, 0x40,
+	};
+	unsigned int pos;
+	int r48;
+
+	/* with the panel off, requests only update what init sends */
+	icna3512_test_clear(t);
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_RATE, 120);
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_BRIGHTNESS, 0x30);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_DSI), 0);
+	KUNIT_EXPECT_EQ(test, icna3512->req_hz, 120);
+	KUNIT_EXPECT_EQ(test, icna3512->dbv, 0x30);
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	r48 = icna3512_test_find_dsi(t, 0, 0, 0x48);
+	KUNIT_ASSERT_GE(test, r48, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[r48].data[1], 0x33);
+
+	/* posting does not wait for the panel lock, the work runs after it */
+	mutex_lock(&icna3512->lock);
+	icna3512_test_clear(t);
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_BRIGHTNESS, 0x20);
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_BRIGHTNESS, 0x40);
+	msleep(20);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+	mutex_unlock(&icna3512->lock);
+
+	/* and only the latest level goes out */
+	flush_work(&icna3512->cmd_work);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dbv, sizeof(dbv));
+	icna3512_test_expect_end(test, pos);
+
+	/* IP block switches coalesce without losing each other's bit */
+	mutex_lock(&icna3512->lock);
+	icna3512_cmd_post_bits(icna3512, ICNA3512_CMD_IP, BIT(ICNA3512_IP_DTR), 0);
+	icna3512_cmd_post_bits(icna3512, ICNA3512_CMD_IP, BIT(ICNA3512_IP_DEMURA), 0);
+	mutex_unlock(&icna3512->lock);
+	flush_work(&icna3512->cmd_work);
+	KUNIT_EXPECT_EQ(test, icna3512->ip_want, BIT(ICNA3512_IP_SHARPNESS));
+}
+
+static void icna3512_test_ip_deltas(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	static const u8 ip_first[] = {
+		0x15, 0x00, 0x02, 0x9F,
+			0x0C,
+		0x15, 0x00, 0x02, 0xB7,		/* DTR off */
+			0xF0,
+		0x15, 0x00, 0x02, 0x9F,
+			0x0D,
+		0x15, 0x00, 0x02, 0xB6,		/* DMR on */
+			0x03,
+		0x15, 0x00, 0x02, 0x9F,
+			0x0E,
+		0x15, 0x00, 0x02, 0xB3,		/* sharpness on */
+			0x41,
+	};
+	static const u8 dtr_on[] = {
+		0x15, 0x00, 0x02, 0x9F,
+			0x0C,
+		0x15, 0x00, 0x02, 0xB7,
+			0xF3,
+	};
+	unsigned long all = GENMASK(ICNA3512_NUM_IP - 1, 0);
+	unsigned int pos;
+	int dtr, dispon;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	mutex_lock(&icna3512->lock);
+
+	/* nothing is known after init, so every block goes out once */
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_panel_set_ip(icna3512, all & ~BIT(ICNA3512_IP_DTR)), 0);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, ip_first, sizeof(ip_first));
+	icna3512_test_expect_end(test, pos);
+
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_panel_set_ip(icna3512, all & ~BIT(ICNA3512_IP_DTR)), 0);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_panel_set_ip(icna3512, all), 0);
+	pos = 0;
+	icna3512_test_expect_seq(test, &pos, dtr_on, sizeof(dtr_on));
+	icna3512_test_expect_end(test, pos);
+
+	mutex_unlock(&icna3512->lock);
+
+	/* a reset forgets the panel state, the next prepare restores it */
+	icna3512_panel_unprepare(&icna3512->base);
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	dtr = icna3512_test_find_dsi(t, 0, 0, 0xB7);
+	dispon = icna3512_test_find_dsi(t, dtr, 0, MIPI_DCS_SET_DISPLAY_ON);
+	KUNIT_ASSERT_GE(test, dtr, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[dtr].data[1], 0xF3);
+	KUNIT_EXPECT_GT(test, dispon, dtr);
+}
+
+/* leave supplies, dcdc-en and reset the way a firmware splash would */
+static void icna3512_test_boot_lit(struct icna3512_test *t, u8 power_mode)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(t->reg_on); i++)
+		t->reg_on[i] = true;
+	t->gpio_val[ICNA3512_TEST_GPIO_RESET] = 0;
+	t->gpio_val[ICNA3512_TEST_GPIO_DCDC_EN] = 1;
+	t->power_mode = power_mode;
+
+	t->icna3512->boot_lit = icna3512_panel_boot_lit(t->icna3512);
+	icna3512_test_clear(t);
+}
+
+static void icna3512_test_adopt(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	u16 dbv = icna3512_dbv(t->icna3512);
+	int r48, bl;
+
+	icna3512_test_boot_lit(t, MIPI_DCS_POWER_MODE_SLEEP |
+			       MIPI_DCS_POWER_MODE_DISPLAY |
+			       MIPI_DCS_POWER_MODE_NORMAL);
+	KUNIT_ASSERT_TRUE(test, t->icna3512->boot_lit);
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_EXPECT_TRUE(test, t->icna3512->prepared);
+	KUNIT_EXPECT_FALSE(test, t->icna3512->boot_lit);
+
+	/* no reset, no supply toggling, no sleep out or display on */
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_GPIO), 0);
+	KUNIT_EXPECT_EQ(test, icna3512_test_count(t, ICNA3512_TEST_EV_REG), 0);
+	KUNIT_EXPECT_LT(test, icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_EXIT_SLEEP_MODE), 0);
+	KUNIT_EXPECT_LT(test, icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_SET_DISPLAY_ON), 0);
+
+	/* the driver's own state still lands */
+	r48 = icna3512_test_find_dsi(t, 0, 0, 0x48);
+	KUNIT_ASSERT_GE(test, r48, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[r48].data[1], 0x03);
+	KUNIT_EXPECT_GE(test, icna3512_test_find_dsi(t, r48, 0, 0xFF), r48);
+	KUNIT_EXPECT_PTR_EQ(test, t->icna3512->gamma, &icna3512_gamma_60hz);
+	KUNIT_EXPECT_TRUE(test, t->icna3512->id_read);
+
+	/* and the level the PWM profile was picked for, last */
+	bl = icna3512_test_find_dsi(t, r48, 0, MIPI_DCS_SET_DISPLAY_BRIGHTNESS);
+	KUNIT_ASSERT_GE(test, bl, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[bl].data[1], dbv >> 8);
+	KUNIT_EXPECT_EQ(test, t->ev[bl].data[2], dbv & 0xff);
+	KUNIT_EXPECT_EQ(test, bl, (int)t->num_ev - 1);
+}
+
+static void icna3512_test_adopt_asleep(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	int pm, slpout;
+
+	/* powered but still in sleep, the firmware never finished */
+	icna3512_test_boot_lit(t, MIPI_DCS_POWER_MODE_NORMAL);
+	KUNIT_ASSERT_TRUE(test, t->icna3512->boot_lit);
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	pm = icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_GET_POWER_MODE);
+	slpout = icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_EXIT_SLEEP_MODE);
+	KUNIT_ASSERT_GE(test, pm, 0);
+	KUNIT_EXPECT_GT(test, slpout, pm);
+	KUNIT_EXPECT_EQ(test, t->gpio_val[ICNA3512_TEST_GPIO_RESET], 0);
+	KUNIT_EXPECT_GT(test, icna3512_test_count(t, ICNA3512_TEST_EV_GPIO), 3);
+
+	/* a panel in reset is never adopted */
+	icna3512_panel_unprepare(&t->icna3512->base);
+	icna3512_test_boot_lit(t, MIPI_DCS_POWER_MODE_SLEEP | MIPI_DCS_POWER_MODE_DISPLAY);
+	t->gpio_val[ICNA3512_TEST_GPIO_RESET] = 1;
+	KUNIT_EXPECT_FALSE(test, icna3512_panel_boot_lit(t->icna3512));
+}
+
+static void icna3512_test_bist(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	struct icna3512_bist_step steps[ICNA3512_BIST_MAX_STEPS];
+	char buf[] = "001F01@20  000001\n";
+	int d6;
+
+	KUNIT_ASSERT_EQ(test, icna3512_bist_parse(buf, steps), 2);
+	KUNIT_EXPECT_EQ(test, steps[0].pattern, 0x001F01);
+	KUNIT_EXPECT_EQ(test, steps[0].dwell_ms, 20);
+	KUNIT_EXPECT_EQ(test, steps[1].pattern, 0x000001);
+	KUNIT_EXPECT_EQ(test, steps[1].dwell_ms, ICNA3512_BIST_DEF_DWELL_MS);
+
+	/* without DRM driving the panel BIST stays off the bus */
+	icna3512_test_clear(t);
+	KUNIT_EXPECT_EQ(test, icna3512_bist_start(icna3512, steps, 2), -ENODEV);
+	KUNIT_EXPECT_FALSE(test, icna3512->prepared);
+	KUNIT_EXPECT_EQ(test, t->num_ev, 0);
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+	KUNIT_ASSERT_EQ(test, icna3512_panel_enable(&icna3512->base), 0);
+
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_bist_start(icna3512, steps, 2), 0);
+	flush_delayed_work(&icna3512->bist_work);
+
+	d6 = icna3512_test_find_dsi(t, 0, 0, 0xD6);
+	KUNIT_ASSERT_GE(test, d6, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[1], 0x01);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[3], 0x1F);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[4], 0x01);
+
+	/* next step once the dwell is over, then round and round */
+	icna3512_test_clear(t);
+	flush_delayed_work(&icna3512->bist_work);
+	d6 = icna3512_test_find_dsi(t, 0, 0, 0xD6);
+	KUNIT_ASSERT_GE(test, d6, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[3], 0x00);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[4], 0x01);
+	KUNIT_EXPECT_EQ(test, icna3512->bist_rounds, 1);
+
+	/* off goes back to video, the panel stays DRM's */
+	icna3512_test_clear(t);
+	icna3512_bist_stop(icna3512);
+	d6 = icna3512_test_find_dsi(t, 0, 0, 0xD6);
+	KUNIT_ASSERT_GE(test, d6, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[d6].data[1], 0x00);
+	KUNIT_EXPECT_FALSE(test, icna3512->bist_running);
+	KUNIT_EXPECT_TRUE(test, icna3512->prepared);
+}
+
+static void icna3512_test_plan_lanes(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct icna3512_panel *icna3512 = t->icna3512;
+	const struct icna3512_mode *modes = icna3512->desc->modes;
+
+	/* no budget in DT: all four lanes, burst clock sized for 165Hz */
+	KUNIT_EXPECT_EQ(test, t->dsi->lanes, 4);
+	KUNIT_EXPECT_EQ(test, icna3512_lane_kbps(icna3512, &modes[0], 4), 887238);
+	KUNIT_EXPECT_EQ(test, t->dsi->hs_rate, 2327598000UL);
+	KUNIT_EXPECT_TRUE(test, icna3512_mode_usable(icna3512, &modes[3]));
+
+	/* at the D-PHY ceiling 165Hz still takes all four */
+	KUNIT_ASSERT_EQ(test, icna3512_plan_lanes(icna3512, 4, true), 0);
+	KUNIT_EXPECT_EQ(test, t->dsi->lanes, 4);
+	KUNIT_EXPECT_EQ(test, t->dsi->hs_rate, 2327598000UL);
+
+	/* three lanes in DT carry 120Hz, not 144Hz */
+	KUNIT_ASSERT_EQ(test, icna3512_plan_lanes(icna3512, 3, true), 0);
+	KUNIT_EXPECT_EQ(test, t->dsi->lanes, 3);
+	KUNIT_EXPECT_EQ(test, t->dsi->hs_rate, 2365976000UL);
+	KUNIT_EXPECT_TRUE(test, icna3512_mode_usable(icna3512, &modes[1]));
+	KUNIT_EXPECT_FALSE(test, icna3512_mode_usable(icna3512, &modes[2]));
+
+	/* a 1Gbps host loses 120Hz but keeps four lanes for 60Hz */
+	icna3512->lane_budget = 1000000;
+	KUNIT_ASSERT_EQ(test, icna3512_plan_lanes(icna3512, 4, true), 0);
+	KUNIT_EXPECT_EQ(test, t->dsi->lanes, 4);
+	KUNIT_EXPECT_EQ(test, t->dsi->hs_rate, 887238000UL);
+	KUNIT_EXPECT_FALSE(test, icna3512_mode_usable(icna3512, &modes[1]));
+	KUNIT_EXPECT_PTR_EQ(test, icna3512->mode, &modes[0]);
+
+	/* nothing fits */
+	icna3512->lane_budget = 500000;
+	KUNIT_EXPECT_EQ(test, icna3512_plan_lanes(icna3512, 4, true), -EINVAL);
+}
+
+static void icna3512_test_dsc_stream(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	struct drm_dsc_config *dsc = &t->icna3512->dsc;
+	int mode, pps, dispon;
+
+	/* what icna3512_panel_get_format() sets up for "chipone,dsc" */
+	dsc->dsc_version_major = 1;
+	dsc->dsc_version_minor = 2;
+	dsc->pic_width = 1080;
+	dsc->pic_height = 1920;
+	dsc->slice_width = 540;
+	dsc->slice_height = 20;
+	dsc->slice_count = 2;
+	dsc->bits_per_component = 10;
+	dsc->bits_per_pixel = 10 << 4;
+	t->dsi->dsc = dsc;
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	/* compression mode then PPS in place of DSC off, ahead of DISP ON */
+	mode = icna3512_test_find_dsi(t, 0, MIPI_DSI_COMPRESSION_MODE, 0x01);
+	pps = icna3512_test_find_dsi(t, 0, MIPI_DSI_PICTURE_PARAMETER_SET, 0x12);
+	dispon = icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_SET_DISPLAY_ON);
+	KUNIT_ASSERT_GE(test, mode, 0);
+	KUNIT_ASSERT_GT(test, pps, mode);
+	KUNIT_EXPECT_GT(test, dispon, pps);
+	KUNIT_EXPECT_EQ(test, t->ev[pps].len, sizeof(struct drm_dsc_picture_parameter_set));
+	KUNIT_EXPECT_EQ(test, t->ev[pps].data[3], 0xA0);	/* 10bpc */
+	KUNIT_EXPECT_EQ(test, icna3512_test_find_dsi(t, 0, 0, 0xC5), -1);
+
+	t->dsi->dsc = NULL;
+}
+
+static void icna3512_test_dual_modes(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	const struct icna3512_panel_desc *desc = t->icna3512->desc;
+	unsigned int i, single = 0, dual = 0;
+
+	/* a 2Gbps host: one link stops at 120Hz, two halve the lane rate */
+	t->icna3512->lane_budget = 2000000;
+
+	for (i = 0; i < desc->num_modes; i++)
+		single += icna3512_mode_usable(t->icna3512, &desc->modes[i]);
+
+	icna3512_test_add_link(test);
+
+	for (i = 0; i < desc->num_modes; i++)
+		dual += icna3512_mode_usable(t->icna3512, &desc->modes[i]);
+
+	KUNIT_EXPECT_EQ(test, single, 2);
+	KUNIT_EXPECT_EQ(test, dual, desc->num_modes);
+}
+
+static void icna3512_test_dual_prepare(struct kunit *test)
+{
+	struct icna3512_test *t = test->priv;
+	static const u8 r48_165hz[] = { 0x15, 0x00, 0x02, 0x48, 0x23 };
+	const struct icna3512_panel_desc *desc = t->icna3512->desc;
+	unsigned int i, n[2] = { };
+	int slpout[2], id;
+	s64 init;
+
+	icna3512_test_add_link(test);
+	icna3512_test_clear(t);
+
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	/* the ID is only read back on the first link */
+	id = icna3512_test_find_dsi(t, 0, 0, MIPI_DCS_GET_DISPLAY_ID);
+	KUNIT_ASSERT_GE(test, id, 0);
+	KUNIT_EXPECT_EQ(test, t->ev[id].link, 0);
+
+	for (i = 0; i < t->num_ev; i++)
+		if (t->ev[i].kind == ICNA3512_TEST_EV_DSI)
+			n[t->ev[i].link]++;
+	/* everything but max return packet size + ID read went out twice */
+	KUNIT_EXPECT_EQ(test, n[1] + 2, n[0]);
+
+	/* both links leave sleep together, the 120ms waits overlap */
+	slpout[0] = icna3512_test_find_link(t, 0, MIPI_DCS_EXIT_SLEEP_MODE);
+	slpout[1] = icna3512_test_find_link(t, 1, MIPI_DCS_EXIT_SLEEP_MODE);
+	KUNIT_ASSERT_GE(test, slpout[0], 0);
+	KUNIT_ASSERT_GE(test, slpout[1], 0);
+	KUNIT_EXPECT_LT(test, abs(ktime_ms_delta(t->ev[slpout[1]].ts,
+						 t->ev[slpout[0]].ts)), 120);
+
+	init = ktime_ms_delta(t->icna3512->stage_ts[ICNA3512_STAGE_DISPON],
+			      t->icna3512->stage_ts[ICNA3512_STAGE_RESET]);
+	KUNIT_EXPECT_LT(test, init, 240);
+
+	/* 165Hz goes to both links */
+	KUNIT_ASSERT_EQ(test, icna3512_panel_unprepare(&t->icna3512->base), 0);
+	icna3512_cmd_post(t->icna3512, ICNA3512_CMD_RATE,
+			  drm_mode_vrefresh(&desc->modes[desc->num_modes - 1].mode));
+	flush_work(&t->icna3512->cmd_work);
+	icna3512_test_clear(t);
+	KUNIT_ASSERT_EQ(test, icna3512_test_prepare(t), 0);
+
+	for (i = 0; i < 2; i++) {
+		int r48 = icna3512_test_find_link(t, i, 0x48);
+
+		KUNIT_ASSERT_GE(test, r48, 0);
+		KUNIT_EXPECT_MEMEQ(test, t->ev[r48].data, &r48_165hz[3], 2);
+		KUNIT_EXPECT_GE(test, icna3512_test_find_link(t, i, 0xFE), r48);
+	}
+}
+
+static struct kunit_case icna3512_test_cases[] = {
+	KUNIT_CASE(icna3512_test_probe_quiet),
+	KUNIT_CASE(icna3512_test_prepare_stream),
+	KUNIT_CASE(icna3512_test_prepare_staged),
+	KUNIT_CASE(icna3512_test_prepare_lpm),
+	KUNIT_CASE(icna3512_test_prepare_power_sequence),
+	KUNIT_CASE(icna3512_test_prepare_stages),
+	KUNIT_CASE(icna3512_test_prepare_twice),
+	KUNIT_CASE(icna3512_test_prepare_regulator_error),
+	KUNIT_CASE(icna3512_test_prepare_init_error),
+	KUNIT_CASE(icna3512_test_prepare_on_error),
+	KUNIT_CASE(icna3512_test_prepare_benching),
+	KUNIT_CASE(icna3512_test_unprepare_sequence),
+	KUNIT_CASE(icna3512_test_id_selects_profile),
+	KUNIT_CASE(icna3512_test_id_fixed_profile),
+	KUNIT_CASE(icna3512_test_id_read_error),
+	KUNIT_CASE(icna3512_test_rate_preference),
+	KUNIT_CASE(icna3512_test_drm_mode),
+	KUNIT_CASE(icna3512_test_pwm_bands),
+	KUNIT_CASE(icna3512_test_cooling),
+	KUNIT_CASE(icna3512_test_queue),
+	KUNIT_CASE(icna3512_test_ip_deltas),
+	KUNIT_CASE(icna3512_test_adopt),
+	KUNIT_CASE(icna3512_test_adopt_asleep),
+	KUNIT_CASE(icna3512_test_bist),
+	KUNIT_CASE(icna3512_test_plan_lanes),
+	KUNIT_CASE(icna3512_test_dsc_stream),
+	KUNIT_CASE(icna3512_test_dual_modes),
+	KUNIT_CASE(icna3512_test_dual_prepare),
+	{ }
+};
+
+static struct kunit_suite icna3512_test_suite = {
+	.name = "panel-chipone-icna3512",
+	.init = icna3512_test_init,
+	.test_cases = icna3512_test_cases,
+};
+kunit_test_suite(icna3512_test_suite);
@@ -1,25 +1,154 @@
 #include <linux/backlight.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gpio/consumer.h>
+#include <linux/ktime.h>
+#include <linux/media-bus-format.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/of_device.h>
+#include <linux/of_graph.h>
+#include <linux/power_supply.h>
 #include <linux/regulator/consumer.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
+#include <linux/thermal.h>
+#include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 #include <video/mipi_display.h>
 
+#include <drm/display/drm_dsc.h>
+#include <drm/display/drm_dsc_helper.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_mipi_dsi.h>
 #include <drm/drm_modes.h>
+#include <drm/drm_of.h>
 #include <drm/drm_panel.h>
+#include <drm/drm_probe_helper.h>
+
+/* D-PHY v1.2 ceiling, used when DT does not give the host's own limit */
+#define ICNA3512_LANE_MBPS_MAX	2500
 
 static const char * const regulator_names[] = {
 	"vddp",
 	"iovcc"
 };
 
+/*
+ * Command sequences are kept in the same packed form as the rk3288
+ * panel-init-sequence the vendor handed us: data type, delay after the
+ * packet in ms, payload length, payload (DCS command followed by params).
+ */
+#define ICNA3512_SEQ_HDR_LEN	3
+
+struct icna3512_gamma_set {
+	const u8 *seq;
+	size_t len;
+};
+
+/*
+ * PWM dimming profile (Group 7) of a mode slot for DBV >= dbv_min. Tables
+ * are ordered from the highest band down, the last band has dbv_min 0.
+ */
+#define ICNA3512_PWM_LEN	7
+#define ICNA3512_NUM_SLOTS	4
+
+/* DBV is 12 bits, sent high byte first; the default is the DXQ vendor level */
+#define ICNA3512_DBV_MAX	0x0FFF
+#define ICNA3512_DBV_DEFAULT	0x0555
+
+struct icna3512_pwm_band {
+	u16 dbv_min;
+	u8 profile[ICNA3512_PWM_LEN];
+};
+
+struct icna3512_pwm_table {
+	const struct icna3512_pwm_band *bands;
+	unsigned int num_bands;
+};
+
+struct icna3512_mode {
+	struct drm_display_mode mode;
+	u8 frame_rate;	/* R48 value, high nibble selects the gamma mode slot */
+	const struct icna3512_gamma_set *gamma;
+	const struct icna3512_pwm_table *pwm;
+};
+
+/*
+ * Init profile of a panel lot: the command sequences around SLP OUT and the
+ * mode table it was tuned for. R48 and the gamma set come from the active
+ * mode and are sent between the two sequences.
+ */
+struct icna3512_panel_desc {
+	const char *name;
+
+	const u8 *init_seq;	/* after reset, before SLP OUT */
+	size_t init_len;
+	const u8 *post_seq;	/* after SLP OUT + 120ms, before DISP ON */
+	size_t post_len;
+
+	const struct icna3512_mode *modes;
+	unsigned int num_modes;
+};
+
+/* optional image processing blocks, see icna3512_ip_blocks[] */
+enum icna3512_ip {
+	ICNA3512_IP_DTR,
+	ICNA3512_IP_DEMURA,
+	ICNA3512_IP_SHARPNESS,
+	ICNA3512_NUM_IP,
+};
+
+/* requests for the command queue, run in this order */
+enum icna3512_cmd {
+	ICNA3512_CMD_COOLING,
+	ICNA3512_CMD_RATE,
+	ICNA3512_CMD_BRIGHTNESS,
+	ICNA3512_CMD_IP,
+	ICNA3512_NUM_CMDS,
+};
+
+/* prepare timestamps, stage N runs from stage_ts[N - 1] to stage_ts[N] */
+enum icna3512_stage {
+	ICNA3512_STAGE_START,
+	ICNA3512_STAGE_REGULATOR,
+	ICNA3512_STAGE_RESET,
+	ICNA3512_STAGE_INIT,
+	ICNA3512_STAGE_SLPOUT,
+	ICNA3512_STAGE_DISPON,
+	ICNA3512_NUM_STAGES,
+};
+
+struct icna3512_bench;
+
+#define ICNA3512_BIST_MAX_STEPS		32
+#define ICNA3512_BIST_DEF_PATTERN	0x001F01
+#define ICNA3512_BIST_DEF_DWELL_MS	1000
+
+struct icna3512_bist_step {
+	u32 pattern;				/* D6 bytes 1..3 */
+	u32 dwell_ms;
+};
+
 struct icna3512_panel {
 	struct drm_panel base;
 	struct mipi_dsi_device *dsi;
+	/* second link of a dual-DSI hookup, NULL when the panel runs off one */
+	struct mipi_dsi_device *dsi_sec;
+
+	/* per lane HS budget of the host(s), kbps, and the lane plan from DT */
+	u32 lane_budget;
+	unsigned int max_lanes;
+	bool lane_shrink;
+
+	/* bits per component scanned out, 8 or 10 */
+	u8 bpc;
+	/* DSC setup handed to the host(s) through dsi->dsc when compressing */
+	struct drm_dsc_config dsc;
+	struct drm_dsc_config dsc_sec;
 
 	struct regulator_bulk_data supplies[ARRAY_SIZE(regulator_names)];
 
@@ -29,8 +158,92 @@ struct icna3512_panel {
 
 	bool prepared;
 	bool enabled;
-
-	const struct drm_display_mode *mode;
+	/* supplies, dcdc-en and reset looked lit at probe, see icna3512_panel_adopt() */
+	bool boot_lit;
+
+	/* protects mode, gamma and the prepared state against queued requests */
+	struct mutex lock;
+
+	/* posted requests, see icna3512_cmd_post() */
+	spinlock_t cmd_lock;
+	unsigned long cmd_pending;
+	unsigned long cmd_val[ICNA3512_NUM_CMDS];
+	struct work_struct cmd_work;
+
+	const struct icna3512_panel_desc *desc;
+	const struct icna3512_mode *mode;
+	/* gamma set currently held by the panel, NULL after reset (OTP) */
+	const struct icna3512_gamma_set *gamma;
+
+	/* refresh rate asked for through sysfs, picks the preferred mode */
+	unsigned int req_hz;
+	/* connector the modes went to, its CRTC mode wins on prepare */
+	struct drm_connector *connector;
+	/* hotplug event for it when the modes on offer change */
+	struct work_struct hotplug_work;
+	/* thermal cooling state, index into icna3512_cooling[] */
+	unsigned long cooling_state;
+
+	/* DBV last asked for through the backlight, see icna3512_dbv() */
+	u16 dbv;
+	/* PWM band each mode slot register holds, NULL after reset (OTP) */
+	const struct icna3512_pwm_band *pwm_live[ICNA3512_NUM_SLOTS];
+	/* profile write staged for the next R48 or brightness write */
+	u8 pwm_seq[2 * ICNA3512_SEQ_HDR_LEN + 2 + 1 + ICNA3512_PWM_LEN];
+	size_t pwm_seq_len;
+
+	/* DCS ID1..ID3, read once on the first prepare */
+	u8 id[3];
+	bool id_read;
+	bool id_valid;
+	/* desc came from a lot specific compatible, the ID only confirms it */
+	bool desc_fixed;
+	/* lot the ID points at, desc_work switches to it once the panel is off */
+	const struct icna3512_panel_desc *id_desc;
+	struct work_struct desc_work;
+	/* links detached for a new lane plan, DRM's prepare is refused */
+	bool relinking;
+
+	/*
+	 * IP blocks, bit per enum icna3512_ip: ip_set marks blocks that have
+	 * been asked for at all (the rest keep their OTP state), ip_want the
+	 * state asked for, ip_live what the panel holds since the last reset.
+	 */
+	unsigned long ip_set;
+	unsigned long ip_want;
+	unsigned long ip_live;
+	unsigned long ip_live_valid;
+	/* follow the power source: full quality on mains, none on battery */
+	bool ip_auto;
+	u32 ip_power_mw[ICNA3512_NUM_IP];
+	u8 ip_seq[ICNA3512_NUM_IP * 10];
+	size_t ip_seq_len;
+	struct notifier_block psy_nb;
+	struct work_struct ip_work;
+
+	/*
+	 * Staged init: prepare stops at DISP ON, tables_work streams the PWM
+	 * profile, gamma set and IP blocks afterwards and opens tables_done.
+	 */
+	bool staged;
+	struct work_struct tables_work;
+	struct completion tables_done;
+	ktime_t tables_ts;
+
+	/*
+	 * BIST cycle: bist_work shows each step for its dwell time, round
+	 * after round, until stopped. Only runs on a panel DRM has up.
+	 */
+	struct icna3512_bist_step bist_steps[ICNA3512_BIST_MAX_STEPS];
+	unsigned int bist_num, bist_cur, bist_rounds;
+	bool bist_running;
+	struct delayed_work bist_work;
+	u8 bist_seq[8];
+
+	ktime_t stage_ts[ICNA3512_NUM_STAGES];
+	struct icna3512_bench *bench;
+	bool benching;		/* power bench owns prepare/unprepare */
+	struct dentry *debugfs;
 };
 
 static inline struct icna3512_panel *to_icna3512_panel(struct drm_panel *panel)
@@ -38,420 +251,3226 @@ static inline struct icna3512_panel *to_icna3512_panel(struct drm_panel *panel)
 	return container_of(panel, struct icna3512_panel, base);
 }
 
-static int icna3512_panel_init(struct icna3512_panel *icna3512)
+static inline void icna3512_stamp(struct icna3512_panel *icna3512,
+				  enum icna3512_stage stage)
 {
-    struct mipi_dsi_device *dsi = icna3512->dsi;
-    struct device *dev = &icna3512->dsi->dev;
-    int ret;
-
-    dev_info(dev, "Sending initial code\n");
+	icna3512->stage_ts[stage] = ktime_get();
+}
 
-    // Command 1 - Vendor Specific? - same as given by vender
-    u8 cmd1[] = {0xA5, 0xA5};
-    ret = mipi_dsi_dcs_write(dsi, 0x9C, cmd1, sizeof(cmd1));
-    if (ret < 0) {
-        return ret;
-    }
+static int icna3512_write_seq(struct mipi_dsi_device *dsi, const u8 *seq, size_t len)
+{
+	size_t i = 0;
+	int ret;
 
-    // Command 2 - Vendor Specific? - same as given by vender
-    u8 cmd2[] = {0x5A, 0x5A};
-    ret = mipi_dsi_dcs_write(dsi, 0xFD, cmd2, sizeof(cmd2));
-    if (ret < 0) {
-        return ret;
-    }
+	while (i + ICNA3512_SEQ_HDR_LEN <= len) {
+		u8 delay = seq[i + 1];
+		u8 count = seq[i + 2];
 
-    // Command 3 - Vendor Specific? - same as given by vender
-    u8 cmd3[] = {0x03};
-    ret = mipi_dsi_dcs_write(dsi, 0x48, cmd3, sizeof(cmd3));
-    if (ret < 0) {
-        return ret;
-    }
+		if (!count || i + ICNA3512_SEQ_HDR_LEN + count > len)
+			return -EINVAL;
 
-    // Command 4 - Vendor Specific? - same as given by vender
-    u8 cmd4[] = {0xE0};
-    ret = mipi_dsi_dcs_write(dsi, 0x53, cmd4, sizeof(cmd4));
-    if (ret < 0) {
-        return ret;
-    }
+		ret = mipi_dsi_dcs_write_buffer(dsi, &seq[i + ICNA3512_SEQ_HDR_LEN], count);
+		if (ret < 0)
+			return ret;
 
-    // Command 5 - Vendor Specific? - same as given by vender
-    u8 cmd5[] = {0x00, 0x00};
-    ret = mipi_dsi_dcs_write(dsi, 0x51, cmd5, sizeof(cmd5));
-    if (ret < 0) {
-        return ret;
-    }
-	/***********************************************************************/
+		if (delay > 20)
+			msleep(delay);
+		else if (delay)
+			usleep_range(delay * 1000, delay * 1000 + 100);
 
-    // Command 6 - MIPI_DCS_SET_TEAR_ON - rk3288 init cmd appears to be setting tearing off? (15 00 02 35 00 vs 05 00 01 35)
-	u8 cmd6[] = {0x00};
-	ret = mipi_dsi_dcs_write(dsi, 0x35, cmd6, sizeof(cmd6));
-	if (ret < 0) {
-		return ret;
+		i += ICNA3512_SEQ_HDR_LEN + count;
 	}
 
-    // // Command 7 - SLP OUT - rk3288 init cmd appears to be setting SLP OUT differently
-	// u8 cmd7[] = {0x01, 0x11};
-	// ret = mipi_dsi_dcs_write(dsi, 0xFF, cmd7, sizeof(cmd7));
-	// if (ret < 0) {
-	// 	return ret;
-	// }
-	
-	// Exit Sleep Mode
-    ret = mipi_dsi_dcs_write(dsi, MIPI_DCS_EXIT_SLEEP_MODE, NULL, 0);
-    if (ret < 0) {
-        return ret;
-    }
+	return i == len ? 0 : -EINVAL;
+}
 
-	// Delay 120ms
-	msleep(120);
-	
-    // Command 8 - MIPI_DCS_SET_DISPLAY_BRIGHTNESS (MIPI DCS 1.3) - rk3288 init cmd appears to be setting a different display brightness
-    // u8 cmd8[] = {0x0D, 0xBB}; // LV=800 of 1000, 4.2v power rail @ grey=0.790W, noise=1.143W ~ 1.152W
-	u8 cmd8[] = {0x05, 0x55};
-    ret = mipi_dsi_dcs_write(dsi, 0x51, cmd8, sizeof(cmd8));
-    if (ret < 0) {
-        return ret;
-    }
+/* Start a record for icna3512_write_seq(): packet type, no delay, length */
+static u8 *icna3512_seq_hdr(u8 *seq, u8 type, u8 len)
+{
+	seq[0] = type;
+	seq[1] = 0;
+	seq[2] = len;
 
-    // Command 9 - Vendor Specific? - same as given by vender
-    u8 cmd9[] = {0x0F};
-    ret = mipi_dsi_dcs_write(dsi, 0x9F, cmd9, sizeof(cmd9));
-    if (ret < 0) {
-        return ret;
-    }
+	return seq + ICNA3512_SEQ_HDR_LEN;
+}
 
-    // Command 10 - Vendor Specific? - same as given by vender
-    u8 cmd10[] = {0x22};
-    ret = mipi_dsi_dcs_write(dsi, 0xCE, cmd10, sizeof(cmd10));
-    if (ret < 0) {
-        return ret;
-    }
+struct icna3512_link_work {
+	struct work_struct work;
+	struct icna3512_panel *icna3512;
+	int (*fn)(struct icna3512_panel *icna3512, struct mipi_dsi_device *dsi);
+	int ret;
+};
+
+static void icna3512_link_work_fn(struct work_struct *work)
+{
+	struct icna3512_link_work *lw = container_of(work, struct icna3512_link_work, work);
 
-	// Command 11 - not seen from given by vendor
-	u8 cmd11[] = {0x01};
-	ret = mipi_dsi_dcs_write(dsi, 0x9F, cmd11, sizeof(cmd11));
+	lw->ret = lw->fn(lw->icna3512, lw->icna3512->dsi_sec);
+}
 
-	// Command 12 - not seen from given by vendor
-	u8 cmd12[] = {0x01};
-	ret = mipi_dsi_dcs_write(dsi, 0xC5, cmd12, sizeof(cmd12));
+/*
+ * Run fn on every link. With dual-DSI the second link is driven from a
+ * worker while the caller drives the first, so both command streams and
+ * their delays overlap and init takes as long as it does on one link.
+ */
+static int icna3512_broadcast(struct icna3512_panel *icna3512,
+			      int (*fn)(struct icna3512_panel *icna3512,
+					struct mipi_dsi_device *dsi))
+{
+	struct icna3512_link_work lw = {
+		.icna3512 = icna3512,
+		.fn = fn,
+	};
+	int ret;
 
-    // // Command 13 - DISP ON - rk3288 init cmd appears to be setting DISP on differently
-    // u8 cmd13[] = {0x01, 0x29};
-	// ret = mipi_dsi_dcs_write(dsi, 0xFF, cmd13, sizeof(cmd13));
-	// if (ret < 0) {
-	// 	return ret;
-	// }
+	if (!icna3512->dsi_sec)
+		return fn(icna3512, icna3512->dsi);
 
-	// Turn the display on
-    ret = mipi_dsi_dcs_write(dsi, MIPI_DCS_SET_DISPLAY_ON, NULL, 0);
-    if (ret < 0) {
-        return ret;
-    }
+	INIT_WORK_ONSTACK(&lw.work, icna3512_link_work_fn);
+	queue_work(system_unbound_wq, &lw.work);
 
-    dev_info(dev, "initial code sent\n");
+	ret = fn(icna3512, icna3512->dsi);
 
-    return 0;
+	flush_work(&lw.work);
+	destroy_work_on_stack(&lw.work);
+
+	return ret < 0 ? ret : lw.ret;
 }
 
-// csvke: BIST, may not need in the end
-// static int icna3512_panel_bist_test(struct mipi_dsi_device *dsi)
-// {
-//     struct device *dev = &dsi->dev;
-//     int ret;
+// Gamma write enable / commit, from Group 6 of the 20240620 GammaRetune script
+static const u8 icna3512_gamma_begin[] = {
+	0x15, 0x00, 0x02, 0x9F,
+		0x05,
+	0x15, 0x00, 0x02, 0xF9,
+		0x80,
+	0x15, 0x00, 0x02, 0xF7,
+		0x10,
+	0x15, 0x00, 0x02, 0x9F,
+		0x06,
+};
+
+static const u8 icna3512_gamma_end[] = {
+	0x15, 0x00, 0x02, 0x9F,
+		0x05,
+	0x15, 0x00, 0x02, 0xF9,
+		0x00,
+	0x15, 0x00, 0x02, 0xF7,
+		0x00,
+	0x15, 0x00, 0x02, 0x9F,
+		0x06,
+	0x39, 0x00, 0x03, 0xFF,
+		0x00, 0x00,
+};
 
-//     // BIST Command
-//     u8 bist_cmd[] = {0x39, 0x00, 0x05, 0xD6, 0x01, 0x00, 0x1F, 0x01};
-//     dev_info(dev, "Sending BIST command 0x39 with data 0x00, 0x05, 0xD6, 0x01, 0x00, 0x1F, 0x01\n");
-//     ret = mipi_dsi_dcs_write(dsi, bist_cmd[0], &bist_cmd[1], sizeof(bist_cmd) - 1);
-//     if (ret < 0) {
-//         dev_err(dev, "Failed to send BIST command: %d\n", ret);
-//         return ret;
-//     }
-//     dev_info(dev, "BIST command sent successfully\n");
+// Mode slot 0 (R48 = 0x03), "60hz Gamma" bands 0-5, DBV 0FFF..0001
+static const u8 icna3512_gamma_slot0_seq[] = {
+	/* band 0 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x00, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xB9, 0x12, 0xEE, 0x6C, 0x33, 0x32, 0xC4, 0x44, 0x39, 0xF0,
+		0x56, 0x84, 0x08, 0x67, 0xEF, 0xCC, 0x9A, 0x8B, 0x7B,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0xFF, 0xFF, 0xAA, 0xFF, 0xFF, 0xAA, 0xFF, 0xFF, 0xAA, 0xFF, 0xFF,
+		0xAA, 0xFF, 0xFF, 0xA0, 0xFF,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x64, 0x22, 0x79, 0xAE, 0x33, 0x31, 0xAE, 0x44, 0x17, 0xC4,
+		0x55, 0x51, 0xCE, 0x67, 0xAA, 0x74, 0x99, 0x0A, 0xDB,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x4D, 0x4D, 0xAA, 0x4D, 0x4D, 0xAA, 0x4D, 0x4D, 0xAA, 0x4D, 0x4D,
+		0xAA, 0x4D, 0x4D, 0xA0, 0x4D,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x59, 0x22, 0x85, 0xED, 0x34, 0xB1, 0x4A, 0x45, 0xBC, 0x75,
+		0x66, 0x0D, 0x8D, 0x78, 0x73, 0x50, 0x9A, 0xFA, 0xDE,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x57, 0x57, 0xBB, 0x57, 0x57, 0xBB, 0x57, 0x57, 0xBB, 0x57, 0x57,
+		0xBB, 0x57, 0x57, 0xB0, 0x57,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 1 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x01, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xEB, 0x23, 0x81, 0x0A, 0x34, 0xF4, 0xA4, 0x56, 0x2C, 0x00,
+		0x67, 0xAE, 0x43, 0x89, 0x50, 0x4A, 0xBC, 0x31, 0x3E,
+	0x39, 0x00, 0x12, 0xF2,
+		0xCC, 0xCD, 0xCD, 0xCC, 0xCD, 0xCD, 0xCC, 0xCD, 0xCD, 0xCC, 0xCD, 0xCD,
+		0xCC, 0xCD, 0xCD, 0xC0, 0xCD,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x85, 0x33, 0x15, 0x6D, 0x34, 0xFE, 0x8C, 0x55, 0x04, 0xCD,
+		0x66, 0x70, 0xFE, 0x78, 0xFE, 0xE6, 0xAB, 0xA2, 0x8B,
+	0x39, 0x00, 0x12, 0xF4,
+		0xCC, 0x08, 0x08, 0xCC, 0x08, 0x08, 0xCC, 0x08, 0x08, 0xCC, 0x08, 0x08,
+		0xCC, 0x08, 0x08, 0xC0, 0x08,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x7D, 0x33, 0x3B, 0xAE, 0x45, 0x90, 0x3C, 0x56, 0xC9, 0xA1,
+		0x77, 0x4E, 0xE9, 0x89, 0xF3, 0xE8, 0xBC, 0xC4, 0xC7,
+	0x39, 0x00, 0x12, 0xF6,
+		0xDD, 0x4B, 0x4B, 0xDD, 0x4B, 0x4B, 0xDD, 0x4B, 0x4B, 0xDD, 0x4B, 0x4B,
+		0xDD, 0x4B, 0x4B, 0xD0, 0x4B,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 2 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x02, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xBE, 0x22, 0x82, 0xE3, 0x34, 0xA1, 0x3A, 0x45, 0xB4, 0x73,
+		0x66, 0x0F, 0x90, 0x78, 0x6F, 0x35, 0x9A, 0xA0, 0x52,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0xAE, 0xAE, 0xAA, 0xAE, 0xAE, 0xAA, 0xAE, 0xAE, 0xAA, 0xAE, 0xAE,
+		0xAA, 0xAE, 0xAE, 0xA0, 0xAE,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x68, 0x23, 0xE0, 0x6B, 0x34, 0xCD, 0x38, 0x45, 0x9F, 0x4D,
+		0x56, 0xDA, 0x54, 0x77, 0x2E, 0xE6, 0x99, 0x38, 0xDB,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x2E, 0x2E, 0xAA, 0x2E, 0x2E, 0xAA, 0x2E, 0x2E, 0xAA, 0x2E, 0x2E,
+		0xAA, 0x2E, 0x2E, 0xA0, 0x2E,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x59, 0x33, 0x3A, 0x8F, 0x44, 0x3F, 0xD3, 0x56, 0x50, 0x15,
+		0x67, 0xAE, 0x30, 0x88, 0x19, 0xD9, 0xAA, 0x3F, 0xEE,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x47, 0x47, 0xBB, 0x47, 0x47, 0xBB, 0x47, 0x47, 0xBB, 0x47, 0x47,
+		0xBB, 0x47, 0x47, 0xB0, 0x47,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 3 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x03, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xAD, 0x22, 0x4D, 0xB0, 0x33, 0x10, 0x71, 0x34, 0xCE, 0x67,
+		0x45, 0xE1, 0x48, 0x56, 0xEF, 0x7B, 0x77, 0x64, 0xCE,
+	0x39, 0x00, 0x12, 0xF2,
+		0x88, 0x01, 0x01, 0x88, 0x01, 0x01, 0x88, 0x01, 0x01, 0x88, 0x01, 0x01,
+		0x88, 0x01, 0x01, 0x80, 0x01,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x59, 0x23, 0xB0, 0x52, 0x33, 0x8E, 0xBC, 0x34, 0xF2, 0x62,
+		0x45, 0xC8, 0x23, 0x56, 0xC0, 0x44, 0x77, 0x27, 0x89,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0xB7, 0xB7, 0x77, 0xB7, 0xB7, 0x77, 0xB7, 0xB7, 0x77, 0xB7, 0xB7,
+		0x77, 0xB7, 0xB7, 0x70, 0xB7,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x12, 0x23, 0xC3, 0x6B, 0x34, 0xB8, 0x14, 0x45, 0x6E, 0x00,
+		0x55, 0x7A, 0xE5, 0x67, 0x8F, 0x1C, 0x88, 0x10, 0x77,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB,
+		0x88, 0xAB, 0xAB, 0x80, 0xAB,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 4 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x04, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0x03, 0x12, 0xC1, 0x6E, 0x33, 0x20, 0x4E, 0x33, 0x82, 0xF6,
+		0x44, 0x6C, 0xDD, 0x56, 0x98, 0x2D, 0x77, 0x15, 0x79,
+	0x39, 0x00, 0x12, 0xF2,
+		0x77, 0xAB, 0xAB, 0x77, 0xAB, 0xAB, 0x77, 0xAB, 0xAB, 0x77, 0xAB, 0xAB,
+		0x77, 0xAB, 0xAB, 0x70, 0xAB,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x09, 0x22, 0x37, 0xAE, 0x34, 0xF1, 0x66, 0x44, 0x75, 0xA4,
+		0x45, 0xDF, 0x1F, 0x56, 0xA0, 0x14, 0x67, 0xE0, 0x3F,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0x6B, 0x6B, 0x77, 0x6B, 0x6B, 0x77, 0x6B, 0x6B, 0x77, 0x6B, 0x6B,
+		0x77, 0x6B, 0x6B, 0x70, 0x6B,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x01, 0x12, 0x80, 0xED, 0x44, 0x4D, 0x72, 0x44, 0x9E, 0xFE,
+		0x55, 0x64, 0xC6, 0x66, 0x6C, 0xF2, 0x78, 0xD7, 0x41,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0x6E, 0x6E, 0x88, 0x6E, 0x6E, 0x88, 0x6E, 0x6E, 0x88, 0x6E, 0x6E,
+		0x88, 0x6E, 0x6E, 0x80, 0x6E,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 5 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x05, 0x00, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0x6B, 0x33, 0x0A, 0x0E, 0x33, 0x23, 0x4D,
+		0x33, 0x7B, 0xB1, 0x44, 0x24, 0x92, 0x55, 0x55, 0xAA,
+	0x39, 0x00, 0x12, 0xF2,
+		0x55, 0xCD, 0xCD, 0x55, 0xCD, 0xCD, 0x55, 0xCD, 0xCD, 0x55, 0xCD, 0xCD,
+		0x55, 0xCD, 0xCD, 0x50, 0xCD,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x01, 0x02, 0xEB, 0xAF, 0x34, 0x34, 0x4C, 0x44, 0x50, 0x62,
+		0x44, 0x73, 0x89, 0x44, 0xB9, 0xF3, 0x55, 0x71, 0xAE,
+	0x39, 0x00, 0x12, 0xF4,
+		0x55, 0xCC, 0xCC, 0x55, 0xCC, 0xCC, 0x55, 0xCC, 0xCC, 0x55, 0xCC, 0xCC,
+		0x55, 0xCC, 0xCC, 0x50, 0xCC,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0xED, 0x34, 0xB3, 0x3A, 0x44, 0x49, 0x6E,
+		0x44, 0x97, 0xC7, 0x55, 0x26, 0x87, 0x66, 0x32, 0x7B,
+	0x39, 0x00, 0x12, 0xF6,
+		0x66, 0xA0, 0xA0, 0x66, 0xA0, 0xA0, 0x66, 0xA0, 0xA0, 0x66, 0xA0, 0xA0,
+		0x66, 0xA0, 0xA0, 0x60, 0xA0,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+};
 
-//     return 0;
-// }
+// Mode slot 2 (R48 = 0x23), "165hz Gamma" bands 0-5
+static const u8 icna3512_gamma_slot2_seq[] = {
+	/* band 0 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x00, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0x88, 0x12, 0xF8, 0x69, 0x33, 0x22, 0xAD, 0x44, 0x20, 0xD3,
+		0x55, 0x69, 0xE9, 0x67, 0xCE, 0xA3, 0x9A, 0x5D, 0x4D,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0xCD, 0xCD, 0xAA, 0xCD, 0xCD, 0xAA, 0xCD, 0xCD, 0xAA, 0xCD, 0xCD,
+		0xAA, 0xCD, 0xCD, 0xA0, 0xCD,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x62, 0x22, 0x8D, 0xB8, 0x33, 0x2D, 0x9B, 0x44, 0x01, 0xAC,
+		0x55, 0x35, 0xB0, 0x67, 0x8A, 0x4E, 0x89, 0xDE, 0xAE,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x1B, 0x1B, 0xAA, 0x1B, 0x1B, 0xAA, 0x1B, 0x1B, 0xAA, 0x1B, 0x1B,
+		0xAA, 0x1B, 0x1B, 0xA0, 0x1B,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x3A, 0x22, 0x94, 0xEF, 0x34, 0xA4, 0x32, 0x45, 0xA7, 0x5C,
+		0x56, 0xF1, 0x70, 0x78, 0x54, 0x29, 0x9A, 0xD0, 0xB0,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x28, 0x28, 0xBB, 0x28, 0x28, 0xBB, 0x28, 0x28, 0xBB, 0x28, 0x28,
+		0xBB, 0x28, 0x28, 0xB0, 0x28,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 1 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x01, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xB8, 0x23, 0x8E, 0x07, 0x34, 0xDE, 0x88, 0x55, 0x0B, 0xDE,
+		0x67, 0x89, 0x1C, 0x89, 0x28, 0x1B, 0xAC, 0xFE, 0x03,
+	0x39, 0x00, 0x12, 0xF2,
+		0xCC, 0x91, 0x91, 0xCC, 0x91, 0x91, 0xCC, 0x91, 0x91, 0xCC, 0x91, 0x91,
+		0xCC, 0x91, 0x91, 0xC0, 0x91,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x89, 0x33, 0x0E, 0x79, 0x34, 0xF6, 0x77, 0x45, 0xED, 0xAE,
+		0x66, 0x4F, 0xDB, 0x78, 0xD4, 0xBB, 0xAB, 0x71, 0x54,
+	0x39, 0x00, 0x12, 0xF4,
+		0xBB, 0xCD, 0xCD, 0xBB, 0xCD, 0xCD, 0xBB, 0xCD, 0xCD, 0xBB, 0xCD, 0xCD,
+		0xBB, 0xCD, 0xCD, 0xB0, 0xCD,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x5F, 0x33, 0x50, 0xB0, 0x45, 0x7E, 0x27, 0x56, 0xAC, 0x83,
+		0x77, 0x2D, 0xC4, 0x89, 0xCE, 0xBE, 0xBC, 0x93, 0x90,
+	0x39, 0x00, 0x12, 0xF6,
+		0xDD, 0x13, 0x13, 0xDD, 0x13, 0x13, 0xDD, 0x13, 0x13, 0xDD, 0x13, 0x13,
+		0xDD, 0x13, 0x13, 0xD0, 0x13,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 2 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x02, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0x95, 0x22, 0x8C, 0xEB, 0x34, 0x8F, 0x23, 0x45, 0x9A, 0x53,
+		0x56, 0xED, 0x6D, 0x78, 0x48, 0x0E, 0x9A, 0x72, 0x24,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0x7B, 0x7B, 0xAA, 0x7B, 0x7B, 0xAA, 0x7B, 0x7B, 0xAA, 0x7B, 0x7B,
+		0xAA, 0x7B, 0x7B, 0xA0, 0x7B,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x6E, 0x23, 0xDF, 0x7D, 0x34, 0xCF, 0x2F, 0x45, 0x8D, 0x31,
+		0x56, 0xBF, 0x36, 0x77, 0x07, 0xBF, 0x99, 0x0F, 0xAF,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x00, 0x00, 0xAA, 0x00, 0x00, 0xAA, 0x00, 0x00, 0xAA, 0x00, 0x00,
+		0xAA, 0x00, 0x00, 0xA0, 0x00,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x46, 0x33, 0x2C, 0x9B, 0x44, 0x33, 0xC1, 0x55, 0x37, 0xF7,
+		0x67, 0x91, 0x11, 0x78, 0xF1, 0xB4, 0xAA, 0x15, 0xC2,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x18, 0x18, 0xBB, 0x18, 0x18, 0xBB, 0x18, 0x18, 0xBB, 0x18, 0x18,
+		0xBB, 0x18, 0x18, 0xB0, 0x18,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 3 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x03, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0x8E, 0x22, 0x3D, 0xBE, 0x33, 0x12, 0x6A, 0x34, 0xBC, 0x50,
+		0x45, 0xC6, 0x29, 0x56, 0xCE, 0x56, 0x77, 0x3E, 0xA4,
+	0x39, 0x00, 0x12, 0xF2,
+		0x77, 0xD4, 0xD4, 0x77, 0xD4, 0xD4, 0x77, 0xD4, 0xD4, 0x77, 0xD4, 0xD4,
+		0x77, 0xD4, 0xD4, 0x70, 0xD4,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x12, 0x23, 0xE9, 0x40, 0x33, 0xA2, 0xC7, 0x34, 0xF3, 0x58,
+		0x45, 0xB6, 0x0C, 0x56, 0xA2, 0x25, 0x67, 0xFE, 0x5E,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0x8D, 0x8D, 0x77, 0x8D, 0x8D, 0x77, 0x8D, 0x8D, 0x77, 0x8D, 0x8D,
+		0x77, 0x8D, 0x8D, 0x70, 0x8D,
+	0x39, 0x00, 0x16, 0xF5,
+		0x01, 0x00, 0xA6, 0x23, 0xCF, 0x80, 0x34, 0xC5, 0x10, 0x44, 0x60, 0xEF,
+		0x55, 0x66, 0xCA, 0x66, 0x71, 0xFC, 0x78, 0xE9, 0x4F,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0x81, 0x81, 0x88, 0x81, 0x81, 0x88, 0x81, 0x81, 0x88, 0x81, 0x81,
+		0x88, 0x81, 0x81, 0x80, 0x81,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 4 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x04, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0xA8, 0x12, 0xA8, 0x67, 0x33, 0x60, 0x70, 0x33, 0x98, 0xF9,
+		0x44, 0x62, 0xC7, 0x56, 0x78, 0x0C, 0x67, 0xF3, 0x4E,
+	0x39, 0x00, 0x12, 0xF2,
+		0x77, 0x86, 0x86, 0x77, 0x86, 0x86, 0x77, 0x86, 0x86, 0x77, 0x86, 0x86,
+		0x77, 0x86, 0x86, 0x70, 0x86,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x01, 0x22, 0x39, 0xC2, 0x34, 0x2C, 0x8C, 0x44, 0x9E, 0xC5,
+		0x45, 0xF4, 0x2A, 0x56, 0x97, 0x05, 0x67, 0xCA, 0x1E,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0x4A, 0x4A, 0x77, 0x4A, 0x4A, 0x77, 0x4A, 0x4A, 0x77, 0x4A, 0x4A,
+		0x77, 0x4A, 0x4A, 0x70, 0x4A,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x01, 0x22, 0x08, 0xEE, 0x34, 0xA4, 0x97, 0x45, 0xBA, 0x0E,
+		0x55, 0x69, 0xBC, 0x66, 0x58, 0xDD, 0x78, 0xBF, 0x20,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0x50, 0x50, 0x88, 0x50, 0x50, 0x88, 0x50, 0x50, 0x88, 0x50, 0x50,
+		0x88, 0x50, 0x50, 0x80, 0x50,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 5 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x05, 0x02, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0x01, 0x02, 0x12, 0x5D, 0x33, 0x2D, 0x39, 0x33, 0x4B, 0x6F,
+		0x33, 0x93, 0xC1, 0x44, 0x21, 0x88, 0x55, 0x2A, 0x89,
+	0x39, 0x00, 0x12, 0xF2,
+		0x55, 0xB0, 0xB0, 0x55, 0xB0, 0xB0, 0x55, 0xB0, 0xB0, 0x55, 0xB0, 0xB0,
+		0x55, 0xB0, 0xB0, 0x50, 0xB0,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x01, 0x02, 0x0E, 0xB8, 0x44, 0x62, 0x77, 0x44, 0x78, 0x8C,
+		0x44, 0x9A, 0xAE, 0x45, 0xD7, 0x07, 0x55, 0x73, 0xA8,
+	0x39, 0x00, 0x12, 0xF4,
+		0x55, 0xBD, 0xBD, 0x55, 0xBD, 0xBD, 0x55, 0xBD, 0xBD, 0x55, 0xBD, 0xBD,
+		0x55, 0xBD, 0xBD, 0x50, 0xBD,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0xEE, 0x34, 0xAD, 0x69, 0x44, 0x74, 0x96,
+		0x44, 0xB6, 0xDC, 0x55, 0x30, 0x85, 0x66, 0x25, 0x69,
+	0x39, 0x00, 0x12, 0xF6,
+		0x66, 0x8B, 0x8B, 0x66, 0x8B, 0x8B, 0x66, 0x8B, 0x8B, 0x66, 0x8B, 0x8B,
+		0x66, 0x8B, 0x8B, 0x60, 0x8B,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+};
 
-static int icna3512_panel_on(struct icna3512_panel *icna3512)
+// Mode slot 3 (R48 = 0x33), retuned for 120Hz ("120hz map mode3"), bands 0-5
+static const u8 icna3512_gamma_slot3_seq[] = {
+	/* band 0 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x00, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xA9, 0x12, 0xDA, 0x51, 0x33, 0x19, 0xAD, 0x44, 0x25, 0xE0,
+		0x55, 0x76, 0xFC, 0x67, 0xEA, 0xC9, 0x9A, 0x85, 0x75,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0xF7, 0xF7, 0xAA, 0xF7, 0xF7, 0xAA, 0xF7, 0xF7, 0xAA, 0xF7, 0xF7,
+		0xAA, 0xF7, 0xF7, 0xA0, 0xF7,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x5F, 0x22, 0x74, 0xA8, 0x33, 0x22, 0x9C, 0x44, 0x09, 0xB7,
+		0x55, 0x4A, 0xCA, 0x67, 0xAB, 0x78, 0x99, 0x0F, 0xE3,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x53, 0x53, 0xAA, 0x53, 0x53, 0xAA, 0x53, 0x53, 0xAA, 0x53, 0x53,
+		0xAA, 0x53, 0x53, 0xA0, 0x53,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x4D, 0x22, 0x78, 0xDC, 0x34, 0x9D, 0x35, 0x45, 0xAF, 0x6E,
+		0x66, 0x09, 0x8E, 0x78, 0x77, 0x56, 0xAA, 0x03, 0xEA,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x62, 0x62, 0xBB, 0x62, 0x62, 0xBB, 0x62, 0x62, 0xBB, 0x62, 0x62,
+		0xBB, 0x62, 0x62, 0xB0, 0x62,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 1 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x01, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xAB, 0x22, 0x6E, 0xEE, 0x34, 0xD3, 0x85, 0x55, 0x0F, 0xEA,
+		0x67, 0x9B, 0x33, 0x89, 0x49, 0x42, 0xBC, 0x2F, 0x38,
+	0x39, 0x00, 0x12, 0xF2,
+		0xCC, 0xC5, 0xC5, 0xCC, 0xC5, 0xC5, 0xCC, 0xC5, 0xC5, 0xCC, 0xC5, 0xC5,
+		0xCC, 0xC5, 0xC5, 0xC0, 0xC5,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x61, 0x33, 0x00, 0x63, 0x34, 0xED, 0x76, 0x45, 0xF0, 0xBD,
+		0x66, 0x64, 0xF5, 0x78, 0xFB, 0xE9, 0xAB, 0xAD, 0x96,
+	0x39, 0x00, 0x12, 0xF4,
+		0xCC, 0x13, 0x13, 0xCC, 0x13, 0x13, 0xCC, 0x13, 0x13, 0xCC, 0x13, 0x13,
+		0xCC, 0x13, 0x13, 0xC0, 0x13,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x4F, 0x33, 0x2F, 0x98, 0x45, 0x7A, 0x2A, 0x56, 0xB4, 0x96,
+		0x77, 0x46, 0xE4, 0x89, 0xF7, 0xEE, 0xBC, 0xD3, 0xD0,
+	0x39, 0x00, 0x12, 0xF6,
+		0xDD, 0x52, 0x52, 0xDD, 0x52, 0x52, 0xDD, 0x52, 0x52, 0xDD, 0x52, 0x52,
+		0xDD, 0x52, 0x52, 0xD0, 0x52,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 2 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x02, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0xB4, 0x22, 0x6D, 0xCE, 0x34, 0x82, 0x1D, 0x45, 0x99, 0x5B,
+		0x56, 0xF7, 0x7D, 0x78, 0x60, 0x2D, 0x9A, 0x9A, 0x4F,
+	0x39, 0x00, 0x12, 0xF2,
+		0xAA, 0xAD, 0xAD, 0xAA, 0xAD, 0xAD, 0xAA, 0xAD, 0xAD, 0xAA, 0xAD, 0xAD,
+		0xAA, 0xAD, 0xAD, 0xA0, 0xAD,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x72, 0x23, 0xCC, 0x67, 0x34, 0xBE, 0x29, 0x45, 0x8C, 0x38,
+		0x56, 0xCD, 0x4B, 0x77, 0x28, 0xE2, 0x99, 0x3B, 0xE1,
+	0x39, 0x00, 0x12, 0xF4,
+		0xAA, 0x33, 0x33, 0xAA, 0x33, 0x33, 0xAA, 0x33, 0x33, 0xAA, 0x33, 0x33,
+		0xAA, 0x33, 0x33, 0xA0, 0x33,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x52, 0x33, 0x2C, 0x7D, 0x44, 0x2C, 0xBD, 0x56, 0x3B, 0x04,
+		0x67, 0xA3, 0x2A, 0x88, 0x17, 0xDB, 0xAA, 0x4B, 0xF9,
+	0x39, 0x00, 0x12, 0xF6,
+		0xBB, 0x52, 0x52, 0xBB, 0x52, 0x52, 0xBB, 0x52, 0x52, 0xBB, 0x52, 0x52,
+		0xBB, 0x52, 0x52, 0xB0, 0x52,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 3 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x03, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x01, 0x00, 0x90, 0x22, 0x1E, 0x9C, 0x23, 0xF6, 0x57, 0x34, 0xB0, 0x4A,
+		0x45, 0xC4, 0x2D, 0x56, 0xD8, 0x68, 0x77, 0x55, 0xC1,
+	0x39, 0x00, 0x12, 0xF2,
+		0x77, 0xF3, 0xF3, 0x77, 0xF3, 0xF3, 0x77, 0xF3, 0xF3, 0x77, 0xF3, 0xF3,
+		0x77, 0xF3, 0xF3, 0x70, 0xF3,
+	0x39, 0x00, 0x16, 0xF3,
+		0x02, 0x00, 0x43, 0x23, 0xB4, 0x42, 0x33, 0x8B, 0xB2, 0x34, 0xE7, 0x4F,
+		0x45, 0xB2, 0x0F, 0x56, 0xAE, 0x35, 0x77, 0x1C, 0x82,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0xB1, 0xB1, 0x77, 0xB1, 0xB1, 0x77, 0xB1, 0xB1, 0x77, 0xB1, 0xB1,
+		0x77, 0xB1, 0xB1, 0x70, 0xB1,
+	0x39, 0x00, 0x16, 0xF5,
+		0x02, 0x00, 0x2C, 0x23, 0xB8, 0x5E, 0x33, 0xAA, 0xFE, 0x44, 0x55, 0xEA,
+		0x55, 0x67, 0xD1, 0x67, 0x82, 0x12, 0x88, 0x0C, 0x77,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB, 0x88, 0xAB, 0xAB,
+		0x88, 0xAB, 0xAB, 0x80, 0xAB,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 4 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x04, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0x01, 0x12, 0xDA, 0xEC, 0x33, 0x18, 0x52, 0x33, 0x80, 0xEC,
+		0x44, 0x5D, 0xCF, 0x56, 0x8A, 0x1F, 0x77, 0x0C, 0x6E,
+	0x39, 0x00, 0x12, 0xF2,
+		0x77, 0xA0, 0xA0, 0x77, 0xA0, 0xA0, 0x77, 0xA0, 0xA0, 0x77, 0xA0, 0xA0,
+		0x77, 0xA0, 0xA0, 0x70, 0xA0,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x60, 0x22, 0x74, 0xE6, 0x44, 0x72, 0x88, 0x44, 0x9A, 0xC3,
+		0x45, 0xF7, 0x31, 0x56, 0xA9, 0x19, 0x67, 0xE3, 0x41,
+	0x39, 0x00, 0x12, 0xF4,
+		0x77, 0x6E, 0x6E, 0x77, 0x6E, 0x6E, 0x77, 0x6E, 0x6E, 0x77, 0x6E, 0x6E,
+		0x77, 0x6E, 0x6E, 0x70, 0x6E,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x03, 0x23, 0x78, 0x3D, 0x44, 0x5E, 0x85, 0x45, 0xAE, 0x0A,
+		0x55, 0x69, 0xC7, 0x66, 0x6A, 0xF2, 0x78, 0xD8, 0x44,
+	0x39, 0x00, 0x12, 0xF6,
+		0x88, 0x72, 0x72, 0x88, 0x72, 0x72, 0x88, 0x72, 0x72, 0x88, 0x72, 0x72,
+		0x88, 0x72, 0x72, 0x80, 0x72,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+	/* band 5 */
+	0x39, 0x00, 0x05, 0xFE,
+		0x01, 0x05, 0x03, 0x00,
+	0x39, 0x00, 0x16, 0xF1,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0x51, 0x33, 0x10, 0x17, 0x33, 0x2E, 0x4F,
+		0x33, 0x7A, 0xAC, 0x44, 0x17, 0x8A, 0x55, 0x4B, 0x9A,
+	0x39, 0x00, 0x12, 0xF2,
+		0x55, 0xC0, 0xC0, 0x55, 0xC0, 0xC0, 0x55, 0xC0, 0xC0, 0x55, 0xC0, 0xC0,
+		0x55, 0xC0, 0xC0, 0x50, 0xC0,
+	0x39, 0x00, 0x16, 0xF3,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0xA7, 0x34, 0x29, 0x70, 0x44, 0x71, 0x84,
+		0x44, 0x95, 0xAB, 0x45, 0xD6, 0x0C, 0x55, 0x7D, 0xB5,
+	0x39, 0x00, 0x12, 0xF4,
+		0x55, 0xD2, 0xD2, 0x55, 0xD2, 0xD2, 0x55, 0xD2, 0xD2, 0x55, 0xD2, 0xD2,
+		0x55, 0xD2, 0xD2, 0x50, 0xD2,
+	0x39, 0x00, 0x16, 0xF5,
+		0x00, 0x00, 0x01, 0x02, 0x02, 0xDC, 0x34, 0xA2, 0x3C, 0x44, 0x5A, 0x81,
+		0x44, 0xAA, 0xD0, 0x55, 0x2D, 0x8B, 0x66, 0x32, 0x7B,
+	0x39, 0x00, 0x12, 0xF6,
+		0x66, 0x9E, 0x9E, 0x66, 0x9E, 0x9E, 0x66, 0x9E, 0x9E, 0x66, 0x9E, 0x9E,
+		0x66, 0x9E, 0x9E, 0x60, 0x9E,
+	0x15, 0x01, 0x02, 0xFF,
+		0x01,
+};
+
+static const struct icna3512_gamma_set icna3512_gamma_60hz = {
+	.seq = icna3512_gamma_slot0_seq,
+	.len = sizeof(icna3512_gamma_slot0_seq),
+};
+
+static const struct icna3512_gamma_set icna3512_gamma_165hz = {
+	.seq = icna3512_gamma_slot2_seq,
+	.len = sizeof(icna3512_gamma_slot2_seq),
+};
+
+static const struct icna3512_gamma_set icna3512_gamma_120hz = {
+	.seq = icna3512_gamma_slot3_seq,
+	.len = sizeof(icna3512_gamma_slot3_seq),
+};
+
+/*
+ * Group 7 of the 20240620 script gives every mode slot its own pulse
+ * profile register, RB2 (NM0, 60Hz) to RB5 (HF3, 144Hz), and 10 pulses a
+ * frame above 60Hz. Below the FPS_HW_THRE of Group 5 (DBV 0x0516) the
+ * short pulses of a 10P frame at 120Hz and up flicker, so the low band
+ * falls back to the 24 pulse NM0 shape.
+ */
+static const struct icna3512_pwm_band icna3512_pwm_nm0_bands[] = {
+	{ 0x0000, { 0x04, 0x18, 0x08, 0x0C, 0x04, 0x00, 0xC4 } },	// 24P
+};
+
+static const struct icna3512_pwm_band icna3512_pwm_hf_bands[] = {
+	{ 0x0516, { 0x04, 0x0A, 0x08, 0x0A, 0x04, 0x00, 0xC4 } },	// 10P
+	{ 0x0000, { 0x04, 0x18, 0x08, 0x0C, 0x04, 0x00, 0xC4 } },	// 24P
+};
+
+static const struct icna3512_pwm_table icna3512_pwm_60hz = {
+	.bands = icna3512_pwm_nm0_bands,
+	.num_bands = ARRAY_SIZE(icna3512_pwm_nm0_bands),
+};
+
+static const struct icna3512_pwm_table icna3512_pwm_hf = {
+	.bands = icna3512_pwm_hf_bands,
+	.num_bands = ARRAY_SIZE(icna3512_pwm_hf_bands),
+};
+
+/*
+ * Thermal cooling states, mildest first: cap the refresh rates offered to
+ * KMS, then scale the DBV once at 60Hz. OLED power follows the emitted
+ * light about linearly, the DBV steps were picked for ~20% less panel
+ * power each.
+ */
+static const struct {
+	u16 max_hz;	/* 0: no cap */
+	u8 dbv_pct;
+} icna3512_cooling[] = {
+	{ 0, 100 },
+	{ 144, 100 },
+	{ 120, 100 },
+	{ 60, 100 },
+	{ 60, 80 },
+	{ 60, 60 },
+	{ 60, 40 },
+};
+
+/* DBV the panel runs at, the backlight level scaled by the cooling state */
+static u16 icna3512_dbv(struct icna3512_panel *icna3512)
+{
+	return icna3512->dbv * icna3512_cooling[icna3512->cooling_state].dbv_pct / 100;
+}
+
+static const struct icna3512_pwm_band *
+icna3512_pwm_band(const struct icna3512_mode *mode, u16 dbv)
+{
+	const struct icna3512_pwm_table *pwm = mode->pwm;
+	unsigned int i;
+
+	if (!pwm)
+		return NULL;
+
+	for (i = 0; i < pwm->num_bands - 1; i++)
+		if (dbv >= pwm->bands[i].dbv_min)
+			break;
+
+	return &pwm->bands[i];
+}
+
+/*
+ * Stage the profile write for the active mode and DBV in pwm_seq, left
+ * empty when the slot register already holds it. It leaves page 07
+ * selected, icna3512_write_pwm() puts page 0F back behind it. Returns the
+ * band to record with icna3512_pwm_commit() once every link took the write.
+ */
+static const struct icna3512_pwm_band *
+icna3512_pwm_stage(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_pwm_band *band = icna3512_pwm_band(icna3512->mode,
+								 icna3512_dbv(icna3512));
+	unsigned int slot = icna3512->mode->frame_rate >> 4;
+	u8 *seq = icna3512->pwm_seq;
+
+	icna3512->pwm_seq_len = 0;
+
+	if (!band || band == icna3512->pwm_live[slot])
+		return NULL;
+
+	seq = icna3512_seq_hdr(seq, 0x15, 2);
+	*seq++ = 0x9F;
+	*seq++ = 0x07;
+	seq = icna3512_seq_hdr(seq, 0x39, 1 + ICNA3512_PWM_LEN);
+	*seq++ = 0xB2 + slot;
+	memcpy(seq, band->profile, ICNA3512_PWM_LEN);
+	seq += ICNA3512_PWM_LEN;
+	icna3512->pwm_seq_len = seq - icna3512->pwm_seq;
+
+	/* the register is unknown until every link took the write */
+	icna3512->pwm_live[slot] = NULL;
+
+	return band;
+}
+
+/* page 0F, the vendor script's default page and the one R48 lives on */
+static const u8 icna3512_page_0f_seq[] = {
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+};
+
+/* the staged profile, if any, with page 0F selected again behind it */
+static int icna3512_write_pwm(struct icna3512_panel *icna3512,
+			      struct mipi_dsi_device *dsi)
 {
-	struct mipi_dsi_device *dsi = icna3512->dsi;
-	struct device *dev = &icna3512->dsi->dev;
 	int ret;
 
-	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+	if (!icna3512->pwm_seq_len)
+		return 0;
 
-	ret = mipi_dsi_dcs_set_display_on(dsi);
+	ret = icna3512_write_seq(dsi, icna3512->pwm_seq, icna3512->pwm_seq_len);
 	if (ret < 0)
-		dev_err(dev, "failed to set display on: %d\n", ret);
+		return ret;
+
+	return icna3512_write_seq(dsi, icna3512_page_0f_seq,
+				  sizeof(icna3512_page_0f_seq));
+}
+
+static void icna3512_pwm_commit(struct icna3512_panel *icna3512,
+				const struct icna3512_pwm_band *band)
+{
+	if (band)
+		icna3512->pwm_live[icna3512->mode->frame_rate >> 4] = band;
+}
+
+/*
+ * R48 selects the frame rate and gamma mode slot. The staged PWM profile
+ * goes out in the same HS burst, so the panel picks both up on the same
+ * frame. Whatever ran before may have left another page selected, so page
+ * 0F is selected right in front of R48 every time.
+ */
+static int icna3512_link_rate(struct icna3512_panel *icna3512,
+			      struct mipi_dsi_device *dsi)
+{
+	unsigned long mode_flags = dsi->mode_flags;
+	int ret;
+
+	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+
+	ret = icna3512_write_seq(dsi, icna3512->pwm_seq, icna3512->pwm_seq_len);
+	if (ret < 0)
+		goto out;
+
+	ret = icna3512_write_seq(dsi, icna3512_page_0f_seq,
+				 sizeof(icna3512_page_0f_seq));
+	if (ret < 0)
+		goto out;
+
+	ret = mipi_dsi_dcs_write(dsi, 0x48, &icna3512->mode->frame_rate, 1);
+
+out:
+	dsi->mode_flags = mode_flags;
 
 	return ret;
 }
 
-static void icna3512_panel_off(struct icna3512_panel *icna3512)
+/*
+ * Send the gamma set of the active mode down one link. The whole set goes
+ * out back to back in HS mode with a single LPM toggle.
+ */
+static int icna3512_link_gamma(struct icna3512_panel *icna3512,
+			       struct mipi_dsi_device *dsi)
 {
-	struct mipi_dsi_device *dsi = icna3512->dsi;
-	struct device *dev = &icna3512->dsi->dev;
+	const struct icna3512_gamma_set *gamma = icna3512->mode->gamma;
+	unsigned long mode_flags = dsi->mode_flags;
 	int ret;
 
+	if (!gamma)
+		return 0;
+
 	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
 
-	ret = mipi_dsi_dcs_set_display_off(dsi);
+	ret = icna3512_write_seq(dsi, icna3512_gamma_begin, sizeof(icna3512_gamma_begin));
 	if (ret < 0)
-		dev_err(dev, "failed to set display off: %d\n", ret);
+		goto out;
 
-	ret = mipi_dsi_dcs_enter_sleep_mode(dsi);
+	ret = icna3512_write_seq(dsi, gamma->seq, gamma->len);
 	if (ret < 0)
-		dev_err(dev, "failed to enter sleep mode: %d\n", ret);
+		goto out;
 
-	msleep(100);
+	ret = icna3512_write_seq(dsi, icna3512_gamma_end, sizeof(icna3512_gamma_end));
+
+out:
+	dsi->mode_flags = mode_flags;
+
+	return ret;
 }
 
-static int icna3512_panel_disable(struct drm_panel *panel)
+/*
+ * Upload the gamma set of the active mode, skipped entirely when the panel
+ * already holds it.
+ */
+static int icna3512_panel_upload_gamma(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_gamma_set *gamma = icna3512->mode->gamma;
+	int ret;
+
+	if (!gamma || gamma == icna3512->gamma)
+		return 0;
+
+	/* the panel state is unknown until the whole set has landed */
+	icna3512->gamma = NULL;
+
+	ret = icna3512_broadcast(icna3512, icna3512_link_gamma);
+	if (ret < 0)
+		return ret;
+
+	icna3512->gamma = gamma;
+
+	return 0;
+}
+
+/*
+ * 144Hz and 165Hz need over 2.1 Gbps per lane on four lanes of RGB888.
+ * icna3512_plan_lanes() drops them when the host cannot run that fast,
+ * unless a dual-DSI hookup splits every line into two 540 pixel halves
+ * (the "2decoder slice width=540" of the vendor script), one per link, at
+ * half the pixel clock each.
+ */
+static const struct icna3512_mode dxq7d0023_modes[] = {
+	{
+		.mode = {
+			.clock		= 1260 * 1956 * 60 / 1000, // htotal * vtotal * 60Hz
+
+			.hdisplay	= 1080, // Hadr in datasheet
+			.hsync_start	= 1080 + 156, // HAdr + HFP
+			.hsync_end	= 1080 + 156 + 1, // HAdr + HFP + Hsync
+			.htotal		= 1080 + 156 + 1 + 23, // HAdr + HFP + Hsync + HBP
+
+			.vdisplay	= 1920, // VAdr in datasheet
+			.vsync_start	= 1920 + 20, // Vadr + VFP
+			.vsync_end	= 1920 + 20 + 1, // Vadr + VFP + Vsync
+			.vtotal		= 1920 + 20 + 1 + 15, // Vadr + VFP + Vsync + VBP
+			.flags = 0, // csvke: ??? maybe 0xA03
+		},
+		.frame_rate = 0x03,
+		.gamma = &icna3512_gamma_60hz,
+		.pwm = &icna3512_pwm_60hz,
+	},
+	{
+		.mode = {
+			.clock		= 1260 * 1956 * 120 / 1000, // htotal * vtotal * 120Hz
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 156,
+			.hsync_end	= 1080 + 156 + 1,
+			.htotal		= 1080 + 156 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 20,
+			.vsync_end	= 1920 + 20 + 1,
+			.vtotal		= 1920 + 20 + 1 + 15,
+		},
+		.frame_rate = 0x33, // "R48 33 //120Hz" in After_OTP_Code_120Hz_10BIT_DSC
+		.gamma = &icna3512_gamma_120hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+	{
+		.mode = {
+			.clock		= 1260 * 1956 * 144 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 156,
+			.hsync_end	= 1080 + 156 + 1,
+			.htotal		= 1080 + 156 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 20,
+			.vsync_end	= 1920 + 20 + 1,
+			.vtotal		= 1920 + 20 + 1 + 15,
+		},
+		.frame_rate = 0x33, // "144hz Gamma" is the slot 3 set
+		.gamma = &icna3512_gamma_120hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+	{
+		.mode = {
+			.clock		= 1202 * 1956 * 165 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 98,
+			.hsync_end	= 1080 + 98 + 1,
+			.htotal		= 1080 + 98 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 20,
+			.vsync_end	= 1920 + 20 + 1,
+			.vtotal		= 1920 + 20 + 1 + 15,
+		},
+		.frame_rate = 0x23,
+		.gamma = &icna3512_gamma_165hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+};
+
+/*
+ * GVO timings from the "mipi.video 1920 1080 fps VBP VFP HBP HFP VSA HSA"
+ * lines of the vendor scripts: up to 144Hz the rate is set by VFP alone, so
+ * those modes run off the same ~355MHz pixel clock; 165Hz also trims HFP.
+ */
+static const struct icna3512_mode g1700fh101gg_modes[] = {
+	{
+		.mode = {
+			.clock		= 1260 * 4696 * 60 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 156,
+			.hsync_end	= 1080 + 156 + 1,
+			.htotal		= 1080 + 156 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 2760,
+			.vsync_end	= 1920 + 2760 + 1,
+			.vtotal		= 1920 + 2760 + 1 + 15,
+		},
+		.frame_rate = 0x03,
+		.gamma = &icna3512_gamma_60hz,
+		.pwm = &icna3512_pwm_60hz,
+	},
+	{
+		.mode = {
+			.clock		= 1260 * 2348 * 120 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 156,
+			.hsync_end	= 1080 + 156 + 1,
+			.htotal		= 1080 + 156 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 412,
+			.vsync_end	= 1920 + 412 + 1,
+			.vtotal		= 1920 + 412 + 1 + 15,
+		},
+		.frame_rate = 0x33,
+		.gamma = &icna3512_gamma_120hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+	{
+		.mode = {
+			.clock		= 1260 * 1956 * 144 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 156,
+			.hsync_end	= 1080 + 156 + 1,
+			.htotal		= 1080 + 156 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 20,
+			.vsync_end	= 1920 + 20 + 1,
+			.vtotal		= 1920 + 20 + 1 + 15,
+		},
+		.frame_rate = 0x33, // "144hz Gamma" is the slot 3 set
+		.gamma = &icna3512_gamma_120hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+	{
+		.mode = {
+			.clock		= 1202 * 1956 * 165 / 1000,
+
+			.hdisplay	= 1080,
+			.hsync_start	= 1080 + 98,
+			.hsync_end	= 1080 + 98 + 1,
+			.htotal		= 1080 + 98 + 1 + 23,
+
+			.vdisplay	= 1920,
+			.vsync_start	= 1920 + 20,
+			.vsync_end	= 1920 + 20 + 1,
+			.vtotal		= 1920 + 20 + 1 + 15,
+		},
+		.frame_rate = 0x23,
+		.gamma = &icna3512_gamma_165hz,
+		.pwm = &icna3512_pwm_hf,
+	},
+};
+
+static const u8 dxq7d0023_init_seq[] = {
+	// Vendor Specific? - same as given by vender
+	0x39, 0x00, 0x03, 0x9C,
+		0xA5, 0xA5,
+	0x39, 0x00, 0x03, 0xFD,
+		0x5A, 0x5A,
+	0x15, 0x00, 0x02, 0x53,
+		0xE0,
+	0x39, 0x00, 0x03, 0x51,
+		0x00, 0x00,
+	// MIPI_DCS_SET_TEAR_ON - rk3288 init cmd appears to be setting tearing off? (15 00 02 35 00 vs 05 00 01 35)
+	0x15, 0x00, 0x02, 0x35,
+		0x00,
+};
+
+static const u8 dxq7d0023_post_seq[] = {
+	// MIPI_DCS_SET_DISPLAY_BRIGHTNESS - rk3288 init cmd appears to be setting a different display brightness
+	// 0x0DBB: LV=800 of 1000, 4.2v power rail @ grey=0.790W, noise=1.143W ~ 1.152W
+	0x39, 0x00, 0x03, 0x51,
+		0x05, 0x55,
+	// Vendor Specific? - same as given by vender
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0xCE,
+		0x22,
+	// DSC off (R9F 01, RC5 01) follows from icna3512_link_dsc()
+};
+
+// FAE "video_60HZ" simple code for the G1700FH101GG V01 OTP code
+static const u8 g1700fh101gg_init_seq[] = {
+	0x39, 0x00, 0x03, 0x9C,
+		0xA5, 0xA5,
+	0x39, 0x00, 0x03, 0xFD,
+		0x5A, 0x5A,
+	0x15, 0x00, 0x02, 0x53,
+		0xE0,
+	0x39, 0x00, 0x03, 0x51,
+		0x00, 0x00,
+	0x05, 0x00, 0x01, 0x35,
+};
+
+static const u8 g1700fh101gg_post_seq[] = {
+	0x39, 0x00, 0x03, 0x51,
+		0x0D, 0xBB,
+	0x15, 0x00, 0x02, 0x9F,
+		0x0F,
+	0x15, 0x00, 0x02, 0xCE,
+		0x22,
+};
+
+static const struct icna3512_panel_desc dxq7d0023_desc = {
+	.name = "DXQ7D0023",
+	.init_seq = dxq7d0023_init_seq,
+	.init_len = sizeof(dxq7d0023_init_seq),
+	.post_seq = dxq7d0023_post_seq,
+	.post_len = sizeof(dxq7d0023_post_seq),
+	.modes = dxq7d0023_modes,
+	.num_modes = ARRAY_SIZE(dxq7d0023_modes),
+};
+
+static const struct icna3512_panel_desc g1700fh101gg_desc = {
+	.name = "G1700FH101GG",
+	.init_seq = g1700fh101gg_init_seq,
+	.init_len = sizeof(g1700fh101gg_init_seq),
+	.post_seq = g1700fh101gg_post_seq,
+	.post_len = sizeof(g1700fh101gg_post_seq),
+	.modes = g1700fh101gg_modes,
+	.num_modes = ARRAY_SIZE(g1700fh101gg_modes),
+};
+
+/*
+ * DCS ID to init profile. The V01 OTP code of the G1700FH101GG writes the
+ * init code version to Group 11 RB4 ("9F 0B / B4 FF 01"), which the IC
+ * reports back as ID2. Lots we have no OTP record for fall through to the
+ * profile of the compatible.
+ */
+static const struct {
+	u8 id[3];
+	u8 mask[3];
+	const struct icna3512_panel_desc *desc;
+} icna3512_id_table[] = {
+	{ { 0x00, 0x01, 0x00 }, { 0x00, 0xff, 0x00 }, &g1700fh101gg_desc },
+};
+
+static const u8 icna3512_dsc_off_seq[] = {
+	0x15, 0x00, 0x02, 0x9F,
+		0x01,
+	0x15, 0x00, 0x02, 0xC5,
+		0x01,
+};
+
+/*
+ * The OTP code leaves the decoder on. An uncompressed link turns it off,
+ * a DSC link sends the PPS built from the config the host filled in.
+ */
+static int icna3512_link_dsc(struct mipi_dsi_device *dsi)
+{
+	struct drm_dsc_picture_parameter_set pps;
+	int ret;
+
+	if (!dsi->dsc)
+		return icna3512_write_seq(dsi, icna3512_dsc_off_seq,
+					  sizeof(icna3512_dsc_off_seq));
+
+	ret = mipi_dsi_compression_mode(dsi, true);
+	if (ret < 0)
+		return ret;
+
+	drm_dsc_pps_payload_pack(&pps, dsi->dsc);
+
+	return mipi_dsi_picture_parameter_set(dsi, &pps);
+}
+
+static int icna3512_link_init(struct icna3512_panel *icna3512,
+			      struct mipi_dsi_device *dsi)
+{
+	const struct icna3512_panel_desc *desc = icna3512->desc;
+	bool primary = dsi == icna3512->dsi;
+	int ret;
+
+	ret = icna3512_write_seq(dsi, desc->init_seq, desc->init_len);
+	if (ret < 0)
+		return ret;
+
+	// Frame rate / gamma mode slot and PWM profile of the active mode
+	ret = icna3512_link_rate(icna3512, dsi);
+	if (ret < 0)
+		return ret;
+
+	// Gamma set of the active refresh rate, before SLP OUT unless staged
+	if (!icna3512->staged) {
+		ret = icna3512_link_gamma(icna3512, dsi);
+		if (ret < 0)
+			return ret;
+	}
+
+	// Exit Sleep Mode
+	ret = mipi_dsi_dcs_write(dsi, MIPI_DCS_EXIT_SLEEP_MODE, NULL, 0);
+	if (ret < 0)
+		return ret;
+
+	if (primary)
+		icna3512_stamp(icna3512, ICNA3512_STAGE_INIT);
+
+	// Delay 120ms
+	msleep(120);
+
+	if (primary)
+		icna3512_stamp(icna3512, ICNA3512_STAGE_SLPOUT);
+
+	ret = icna3512_write_seq(dsi, desc->post_seq, desc->post_len);
+	if (ret < 0)
+		return ret;
+
+	ret = icna3512_link_dsc(dsi);
+	if (ret < 0)
+		return ret;
+
+	// Turn the display on
+	return mipi_dsi_dcs_write(dsi, MIPI_DCS_SET_DISPLAY_ON, NULL, 0);
+}
+
+/*
+ * HS rate in kbps each lane of a link needs for a mode: the link's share of
+ * the pixel clock at the bpp on the wire (the compressed one with DSC),
+ * spread over the lanes. Blanking goes out in LP in burst mode, so this is
+ * the floor the host's burst clock has to meet.
+ */
+static u32 icna3512_lane_kbps(struct icna3512_panel *icna3512,
+			      const struct icna3512_mode *mode, unsigned int lanes)
+{
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	unsigned int links = icna3512->dsi_sec ? 2 : 1;
+	u32 bpp16;	/* U6.4 like drm_dsc_config.bits_per_pixel */
+
+	if (dsi->dsc)
+		bpp16 = dsi->dsc->bits_per_pixel;
+	else
+		bpp16 = mipi_dsi_pixel_format_to_bpp(dsi->format) << 4;
+
+	return DIV_ROUND_UP_ULL((u64)mode->mode.clock * bpp16, 16 * links * lanes);
+}
+
+static bool icna3512_mode_usable(struct icna3512_panel *icna3512,
+				 const struct icna3512_mode *mode)
+{
+	return icna3512_lane_kbps(icna3512, mode, icna3512->dsi->lanes) <=
+	       icna3512->lane_budget;
+}
+
+static const struct icna3512_mode *
+icna3512_first_usable(struct icna3512_panel *icna3512,
+		      const struct icna3512_panel_desc *desc)
+{
+	unsigned int i;
+
+	for (i = 0; i < desc->num_modes; i++)
+		if (icna3512_mode_usable(icna3512, &desc->modes[i]))
+			return &desc->modes[i];
+
+	return NULL;
+}
+
+/*
+ * Modes over the budget at max_lanes are dropped rather than left to fail
+ * on the wire. With shrink, pick the fewest lanes that still carry every
+ * mode left, and ask the host for no more burst clock than the fastest of
+ * them needs.
+ */
+static int icna3512_plan_lanes(struct icna3512_panel *icna3512,
+			       unsigned int max_lanes, bool shrink)
+{
+	const struct icna3512_panel_desc *desc = icna3512->desc;
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	struct device *dev = &dsi->dev;
+	u64 total = 0;	/* kbps over all lanes of a link */
+	unsigned int i, lanes;
+
+	icna3512->max_lanes = max_lanes;
+	icna3512->lane_shrink = shrink;
+	dsi->lanes = max_lanes;
+
+	for (i = 0; i < desc->num_modes; i++) {
+		const struct icna3512_mode *m = &desc->modes[i];
+
+		if (icna3512_mode_usable(icna3512, m))
+			total = max_t(u64, total, icna3512_lane_kbps(icna3512, m, 1));
+		else
+			dev_info(dev, "%ux%u@%u needs %u kbps per lane, over budget\n",
+				 m->mode.hdisplay, m->mode.vdisplay,
+				 drm_mode_vrefresh(&m->mode),
+				 icna3512_lane_kbps(icna3512, m, max_lanes));
+	}
+
+	if (!total)
+		return dev_err_probe(dev, -EINVAL,
+				     "no %s mode fits %u lanes at %u kbps\n",
+				     desc->name, max_lanes, icna3512->lane_budget);
+
+	lanes = shrink ? DIV_ROUND_UP_ULL(total, icna3512->lane_budget) : max_lanes;
+
+	dsi->lanes = lanes;
+	dsi->hs_rate = DIV_ROUND_UP_ULL(total, lanes) * 1000;
+
+	if (icna3512->dsi_sec) {
+		icna3512->dsi_sec->lanes = dsi->lanes;
+		icna3512->dsi_sec->hs_rate = dsi->hs_rate;
+	}
+
+	if (!icna3512_mode_usable(icna3512, icna3512->mode))
+		icna3512->mode = icna3512_first_usable(icna3512, desc);
+
+	dev_info(dev, "%u of %u lanes, %lu kbps per lane\n", lanes, max_lanes,
+		 dsi->hs_rate / 1000);
+
+	return 0;
+}
+
+static int icna3512_panel_init(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_pwm_band *pwm;
+	struct device *dev = &icna3512->dsi->dev;
+	int ret;
+
+	dev_info(dev, "Sending initial code (%s%s%s)\n", icna3512->desc->name,
+		 icna3512->dsi_sec ? ", dual-DSI" : "",
+		 icna3512->staged ? ", staged" : "");
+
+	// a staged init leaves the PWM profile and gamma to tables_work
+	pwm = NULL;
+	icna3512->pwm_seq_len = 0;
+	if (!icna3512->staged)
+		pwm = icna3512_pwm_stage(icna3512);
+
+	ret = icna3512_broadcast(icna3512, icna3512_link_init);
+	if (ret < 0)
+		return ret;
+
+	if (!icna3512->staged)
+		icna3512->gamma = icna3512->mode->gamma;
+	icna3512_pwm_commit(icna3512, pwm);
+
+	dev_info(dev, "initial code sent\n");
+
+	return 0;
+}
+
+static int icna3512_panel_read_id(struct icna3512_panel *icna3512)
+{
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	unsigned long mode_flags = dsi->mode_flags;
+	int ret;
+
+	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+
+	ret = mipi_dsi_set_maximum_return_packet_size(dsi, sizeof(icna3512->id));
+	if (ret < 0)
+		goto out;
+
+	ret = mipi_dsi_dcs_read(dsi, MIPI_DCS_GET_DISPLAY_ID, icna3512->id,
+				sizeof(icna3512->id));
+	if (ret >= 0 && ret != sizeof(icna3512->id))
+		ret = -EIO;
+
+out:
+	dsi->mode_flags = mode_flags;
+
+	return ret < 0 ? ret : 0;
+}
+
+/*
+ * Read the DCS ID once, right after the first reset, and note the init
+ * profile of the lot it belongs to. Done here rather than in probe so that
+ * probe does not have to power the panel up. A failed read is not fatal,
+ * the profile of the compatible is used as is. The commit that got us here
+ * runs on the timings of the old mode table, so the switch itself waits
+ * for desc_work once the panel is off.
+ */
+static void icna3512_panel_identify(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_panel_desc *desc = NULL;
+	struct device *dev = &icna3512->dsi->dev;
+	unsigned int i, j;
+	int ret;
+
+	icna3512->id_read = true;
+
+	ret = icna3512_panel_read_id(icna3512);
+	if (ret < 0) {
+		dev_warn(dev, "failed to read panel ID: %d\n", ret);
+		return;
+	}
+
+	icna3512->id_valid = true;
+
+	for (i = 0; i < ARRAY_SIZE(icna3512_id_table) && !desc; i++) {
+		desc = icna3512_id_table[i].desc;
+		for (j = 0; j < sizeof(icna3512->id); j++)
+			if ((icna3512->id[j] ^ icna3512_id_table[i].id[j]) &
+			    icna3512_id_table[i].mask[j])
+				desc = NULL;
+	}
+
+	dev_info(dev, "panel ID %02x %02x %02x (%s)\n", icna3512->id[0],
+		 icna3512->id[1], icna3512->id[2], desc ? desc->name : "unknown");
+
+	if (!desc || desc == icna3512->desc)
+		return;
+
+	if (icna3512->desc_fixed) {
+		dev_info(dev, "keeping %s profile from the compatible\n",
+			 icna3512->desc->name);
+		return;
+	}
+
+	dev_info(dev, "switching to the %s profile once the panel is off\n",
+		 desc->name);
+	icna3512->id_desc = desc;
+}
+
+/*
+ * BIST: the IC draws its own pattern and ignores the video stream. D6
+ * takes an enable byte and three pattern bytes, the vendor script's
+ * pattern is 00 1F 01.
+ */
+static int icna3512_link_bist(struct icna3512_panel *icna3512,
+			      struct mipi_dsi_device *dsi)
+{
+	return icna3512_write_seq(dsi, icna3512->bist_seq, sizeof(icna3512->bist_seq));
+}
+
+static int icna3512_panel_bist(struct icna3512_panel *icna3512, bool on,
+			       u32 pattern)
+{
+	u8 *seq = icna3512->bist_seq;
+
+	seq = icna3512_seq_hdr(seq, 0x39, 5);
+	*seq++ = 0xD6;
+	*seq++ = on;
+	*seq++ = pattern >> 16;
+	*seq++ = pattern >> 8;
+	*seq++ = pattern;
+
+	return icna3512_broadcast(icna3512, icna3512_link_bist);
+}
+
+static int icna3512_link_on(struct icna3512_panel *icna3512,
+			    struct mipi_dsi_device *dsi)
+{
+	struct device *dev = &dsi->dev;
+	int ret;
+
+	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+
+	ret = mipi_dsi_dcs_set_display_on(dsi);
+	if (ret < 0)
+		dev_err(dev, "failed to set display on: %d\n", ret);
+
+	return ret;
+}
+
+static int icna3512_panel_on(struct icna3512_panel *icna3512)
+{
+	return icna3512_broadcast(icna3512, icna3512_link_on);
+}
+
+static int icna3512_link_off(struct icna3512_panel *icna3512,
+			     struct mipi_dsi_device *dsi)
+{
+	struct device *dev = &dsi->dev;
+	int ret;
+
+	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+
+	ret = mipi_dsi_dcs_set_display_off(dsi);
+	if (ret < 0)
+		dev_err(dev, "failed to set display off: %d\n", ret);
+
+	ret = mipi_dsi_dcs_enter_sleep_mode(dsi);
+	if (ret < 0)
+		dev_err(dev, "failed to enter sleep mode: %d\n", ret);
+
+	msleep(100);
+
+	return 0;
+}
+
+static void icna3512_panel_off(struct icna3512_panel *icna3512)
+{
+	icna3512_broadcast(icna3512, icna3512_link_off);
+}
+
+/*
+ * Image processing blocks from the "IP List" of the vendor scripts. Each is
+ * switched by the first parameter of one register; the scripts only give
+ * sharpness's on value, off clears the enable bit the way DTR and DMR do.
+ */
+static const struct {
+	const char *name;
+	u8 page;
+	u8 reg;
+	u8 on;
+	u8 off;
+} icna3512_ip_blocks[] = {
+	[ICNA3512_IP_DTR] = { "dtr", 0x0C, 0xB7, 0xF3, 0xF0 },
+	[ICNA3512_IP_DEMURA] = { "demura", 0x0D, 0xB6, 0x03, 0x00 },
+	[ICNA3512_IP_SHARPNESS] = { "sharpness", 0x0E, 0xB3, 0x41, 0x40 },
+};
+
+static int icna3512_link_ip(struct icna3512_panel *icna3512,
+			    struct mipi_dsi_device *dsi)
+{
+	return icna3512_write_seq(dsi, icna3512->ip_seq, icna3512->ip_seq_len);
+}
+
+/*
+ * Bring the panel's IP blocks in line with ip_want, writing only the blocks
+ * whose state differs from (or is unknown on) the panel. Called with the
+ * lock held.
+ */
+static int icna3512_panel_apply_ip(struct icna3512_panel *icna3512)
+{
+	unsigned long todo = icna3512->ip_set &
+			     (~icna3512->ip_live_valid |
+			      (icna3512->ip_want ^ icna3512->ip_live));
+	u8 *seq = icna3512->ip_seq;
+	unsigned int i;
+	int ret;
+
+	if (!todo)
+		return 0;
+
+	for_each_set_bit(i, &todo, ICNA3512_NUM_IP) {
+		bool on = test_bit(i, &icna3512->ip_want);
+
+		seq = icna3512_seq_hdr(seq, 0x15, 2);
+		*seq++ = 0x9F;
+		*seq++ = icna3512_ip_blocks[i].page;
+		seq = icna3512_seq_hdr(seq, 0x15, 2);
+		*seq++ = icna3512_ip_blocks[i].reg;
+		*seq++ = on ? icna3512_ip_blocks[i].on : icna3512_ip_blocks[i].off;
+	}
+	icna3512->ip_seq_len = seq - icna3512->ip_seq;
+
+	/* state is unknown until every link took the write */
+	icna3512->ip_live_valid &= ~todo;
+
+	ret = icna3512_broadcast(icna3512, icna3512_link_ip);
+	if (ret < 0)
+		return ret;
+
+	icna3512->ip_live = (icna3512->ip_live & ~todo) | (icna3512->ip_want & todo);
+	icna3512->ip_live_valid |= todo;
+
+	return 0;
+}
+
+static int icna3512_panel_set_ip(struct icna3512_panel *icna3512,
+				 unsigned long want)
+{
+	icna3512->ip_set = GENMASK(ICNA3512_NUM_IP - 1, 0);
+	icna3512->ip_want = want;
+
+	if (!icna3512->prepared)
+		return 0;
+
+	return icna3512_panel_apply_ip(icna3512);
+}
+
+/*
+ * Usable mode closest to rate, kept at or under the refresh cap of the
+ * cooling state. With nothing under the cap the slowest mode is used.
+ */
+static const struct icna3512_mode *
+icna3512_pick_mode(struct icna3512_panel *icna3512, unsigned int rate)
+{
+	unsigned int cap = icna3512_cooling[icna3512->cooling_state].max_hz;
+	const struct icna3512_mode *mode = NULL;
+	bool fits = false;
+	unsigned int i;
+
+	for (i = 0; i < icna3512->desc->num_modes; i++) {
+		const struct icna3512_mode *m = &icna3512->desc->modes[i];
+		int hz = drm_mode_vrefresh(&m->mode);
+		bool m_fits = !cap || hz <= cap;
+
+		if (!icna3512_mode_usable(icna3512, m))
+			continue;
+
+		if (mode) {
+			int best = drm_mode_vrefresh(&mode->mode);
+
+			// anything under the cap beats anything over it
+			if (m_fits != fits) {
+				if (fits)
+					continue;
+			} else if (fits ? abs(hz - (int)rate) >= abs(best - (int)rate) :
+					  hz >= best) {
+				continue;
+			}
+		}
+
+		mode = m;
+		fits = m_fits;
+	}
+
+	return mode;
+}
+
+/*
+ * Modes KMS gets to see: the usable ones at or under the refresh cap of
+ * the cooling state. The preferred mode is always in, pick_mode() falls
+ * back to the slowest when nothing fits under the cap.
+ */
+static bool icna3512_mode_offered(struct icna3512_panel *icna3512,
+				  const struct icna3512_mode *mode)
+{
+	unsigned int cap = icna3512_cooling[READ_ONCE(icna3512->cooling_state)].max_hz;
+
+	if (!icna3512_mode_usable(icna3512, mode))
+		return false;
+
+	return !cap || drm_mode_vrefresh(&mode->mode) <= cap ||
+	       mode == icna3512_pick_mode(icna3512, icna3512->req_hz);
+}
+
+/*
+ * Mode the CRTC in front of us scans out. Prepare runs from the bridge
+ * chain's pre_enable in the commit tail, after the state swap, so the
+ * connector's state is the one being committed. NULL outside a commit
+ * or for a mode we did not offer.
+ */
+static const struct icna3512_mode *
+icna3512_drm_mode(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_panel_desc *desc = icna3512->desc;
+	struct drm_connector *connector = icna3512->connector;
+	const struct drm_display_mode *m;
+	unsigned int i;
+
+	if (!connector || !connector->state || !connector->state->crtc ||
+	    !connector->state->crtc->state)
+		return NULL;
+
+	m = &connector->state->crtc->state->mode;
+
+	for (i = 0; i < desc->num_modes; i++)
+		if (icna3512_mode_usable(icna3512, &desc->modes[i]) &&
+		    drm_mode_match(m, &desc->modes[i].mode,
+				   DRM_MODE_MATCH_TIMINGS | DRM_MODE_MATCH_CLOCK))
+			return &desc->modes[i];
+
+	return NULL;
+}
+
+/*
+ * The mode DRM set decides R48 and the gamma set the init sends: the
+ * scanout timing and the panel's rate must agree, even for a mode the
+ * cooling cap no longer offers. req_hz is left alone, it is what the
+ * preferred mode goes back to once the cap lifts. Without a commit (the
+ * power bench) or for a mode we did not offer, the preferred mode is
+ * used. Called with the lock held, before the panel is up.
+ */
+static void icna3512_take_drm_mode(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_mode *mode = icna3512_drm_mode(icna3512);
+
+	if (!mode)
+		mode = icna3512_pick_mode(icna3512, icna3512->req_hz);
+
+	icna3512->mode = mode;
+}
+
+/*
+ * Refresh rate asked for through sysfs. It only moves the preferred mode
+ * offered to KMS, the running panel keeps the rate of the mode scanned
+ * out until a modeset picks another one. Called with the lock held.
+ */
+static int icna3512_panel_set_rate(struct icna3512_panel *icna3512,
+				   unsigned int rate)
+{
+	if (rate == icna3512->req_hz)
+		return 0;
+
+	icna3512->req_hz = rate;
+	schedule_work(&icna3512->hotplug_work);
+
+	return 0;
+}
+
+/* DBV with the PWM profile of its band in front when that changes */
+static int icna3512_link_dbv(struct icna3512_panel *icna3512,
+			     struct mipi_dsi_device *dsi)
+{
+	unsigned long mode_flags = dsi->mode_flags;
+	int ret;
+
+	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+
+	ret = icna3512_write_pwm(icna3512, dsi);
+	if (ret < 0)
+		goto out;
+
+	ret = mipi_dsi_dcs_set_display_brightness_large(dsi, icna3512_dbv(icna3512));
+
+out:
+	dsi->mode_flags = mode_flags;
+
+	return ret;
+}
+
+/* Backlight level, called with the lock held */
+static int icna3512_panel_write_dbv(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_pwm_band *pwm;
+	int ret;
+
+	pwm = icna3512_pwm_stage(icna3512);
+
+	ret = icna3512_broadcast(icna3512, icna3512_link_dbv);
+	if (ret < 0)
+		return ret;
+
+	icna3512_pwm_commit(icna3512, pwm);
+
+	return 0;
+}
+
+static int icna3512_panel_set_dbv(struct icna3512_panel *icna3512, u16 dbv)
+{
+	icna3512->dbv = dbv;
+
+	// init and adopt pick the level up from here
+	if (!icna3512->prepared)
+		return 0;
+
+	return icna3512_panel_write_dbv(icna3512);
+}
+
+/*
+ * A cooling step scales the DBV right away. The rate cap only changes
+ * which modes get_modes() offers: R48 and the gamma set stay with the
+ * mode KMS scans out, the hotplug event has userspace re-probe and move
+ * off a mode over the cap with a modeset. Called with the lock held.
+ */
+static int icna3512_panel_set_cooling(struct icna3512_panel *icna3512,
+				      unsigned long state)
+{
+	unsigned long old = icna3512->cooling_state;
+
+	if (state == old)
+		return 0;
+
+	WRITE_ONCE(icna3512->cooling_state, state);
+
+	if (icna3512_cooling[state].max_hz != icna3512_cooling[old].max_hz)
+		schedule_work(&icna3512->hotplug_work);
+
+	if (!icna3512->prepared ||
+	    icna3512_cooling[state].dbv_pct == icna3512_cooling[old].dbv_pct)
+		return 0;
+
+	return icna3512_panel_write_dbv(icna3512);
+}
+
+/*
+ * Command queue. Backlight, rate, cooling and IP block requests are posted
+ * here and return at once, the DSI traffic is serialized with prepare and
+ * unprepare by cmd_work under the panel lock. Requests of a kind coalesce,
+ * only the latest value is applied.
+ */
+static void icna3512_cmd_post_bits(struct icna3512_panel *icna3512,
+				   enum icna3512_cmd cmd, unsigned long mask,
+				   unsigned long val)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&icna3512->cmd_lock, flags);
+	icna3512->cmd_val[cmd] = (icna3512->cmd_val[cmd] & ~mask) | (val & mask);
+	__set_bit(cmd, &icna3512->cmd_pending);
+	spin_unlock_irqrestore(&icna3512->cmd_lock, flags);
+
+	queue_work(system_wq, &icna3512->cmd_work);
+}
+
+static void icna3512_cmd_post(struct icna3512_panel *icna3512,
+			      enum icna3512_cmd cmd, unsigned long val)
+{
+	icna3512_cmd_post_bits(icna3512, cmd, ~0UL, val);
+}
+
+/* Run the posted requests in enum order, called with the lock held */
+static void icna3512_cmd_run(struct icna3512_panel *icna3512)
+{
+	struct device *dev = &icna3512->dsi->dev;
+	unsigned long val[ICNA3512_NUM_CMDS];
+	unsigned long pending, flags;
+	unsigned int i;
+	int ret;
+
+	spin_lock_irqsave(&icna3512->cmd_lock, flags);
+	pending = icna3512->cmd_pending;
+	icna3512->cmd_pending = 0;
+	memcpy(val, icna3512->cmd_val, sizeof(val));
+	spin_unlock_irqrestore(&icna3512->cmd_lock, flags);
+
+	for_each_set_bit(i, &pending, ICNA3512_NUM_CMDS) {
+		switch (i) {
+		case ICNA3512_CMD_COOLING:
+			ret = icna3512_panel_set_cooling(icna3512, val[i]);
+			break;
+		case ICNA3512_CMD_RATE:
+			ret = icna3512_panel_set_rate(icna3512, val[i]);
+			break;
+		case ICNA3512_CMD_BRIGHTNESS:
+			ret = icna3512_panel_set_dbv(icna3512, val[i]);
+			break;
+		case ICNA3512_CMD_IP:
+			ret = icna3512_panel_set_ip(icna3512, val[i]);
+			break;
+		default:
+			ret = 0;
+			break;
+		}
+
+		if (ret < 0)
+			dev_err(dev, "queued command %u (%lu) failed: %d\n",
+				i, val[i], ret);
+	}
+}
+
+static void icna3512_cmd_cancel(void *data)
+{
+	struct icna3512_panel *icna3512 = data;
+
+	cancel_work_sync(&icna3512->cmd_work);
+	cancel_work_sync(&icna3512->hotplug_work);
+}
+
+static void icna3512_cmd_work_fn(struct work_struct *work)
+{
+	struct icna3512_panel *icna3512 = container_of(work, struct icna3512_panel,
+						       cmd_work);
+
+	mutex_lock(&icna3512->lock);
+	icna3512_cmd_run(icna3512);
+	mutex_unlock(&icna3512->lock);
+}
+
+/*
+ * Outside the panel lock: the fbdev client may modeset from the event,
+ * which ends up in prepare.
+ */
+static void icna3512_hotplug_work_fn(struct work_struct *work)
+{
+	struct icna3512_panel *icna3512 = container_of(work, struct icna3512_panel,
+						       hotplug_work);
+	struct drm_connector *connector = READ_ONCE(icna3512->connector);
+
+	if (connector)
+		drm_kms_helper_hotplug_event(connector->dev);
+}
+
+static void icna3512_ip_work_fn(struct work_struct *work)
+{
+	struct icna3512_panel *icna3512 = container_of(work, struct icna3512_panel,
+						       ip_work);
+	/* no power supply info at all counts as mains */
+	bool mains = power_supply_is_system_supplied() != 0;
+
+	if (READ_ONCE(icna3512->ip_auto))
+		icna3512_cmd_post(icna3512, ICNA3512_CMD_IP,
+				  mains ? GENMASK(ICNA3512_NUM_IP - 1, 0) : 0);
+}
+
+static int icna3512_psy_notify(struct notifier_block *nb, unsigned long event,
+			       void *data)
+{
+	struct icna3512_panel *icna3512 = container_of(nb, struct icna3512_panel, psy_nb);
+
+	if (event == PSY_EVENT_PROP_CHANGED && READ_ONCE(icna3512->ip_auto))
+		schedule_work(&icna3512->ip_work);
+
+	return NOTIFY_OK;
+}
+
+// Unlock keys the vendor init code opens with, the user registers sit behind them
+static const u8 icna3512_unlock_seq[] = {
+	0x39, 0x00, 0x03, 0x9C,
+		0xA5, 0xA5,
+	0x39, 0x00, 0x03, 0xFD,
+		0x5A, 0x5A,
+};
+
+static int icna3512_link_adopt(struct icna3512_panel *icna3512,
+			       struct mipi_dsi_device *dsi)
+{
+	int ret;
+
+	ret = icna3512_write_seq(dsi, icna3512_unlock_seq, sizeof(icna3512_unlock_seq));
+	if (ret < 0)
+		return ret;
+
+	ret = icna3512_link_dsc(dsi);
+	if (ret < 0)
+		return ret;
+
+	return icna3512_link_rate(icna3512, dsi);
+}
+
+/*
+ * First prepare after the firmware left the panel lit: when the IC reports
+ * sleep out and display on, take it over without reset, init code or SLP
+ * OUT so the splash stays up. Only what the driver sets up itself (DSC,
+ * frame rate, PWM profile, gamma and IP blocks) is brought in line, the
+ * same way init sends it, and the DBV the PWM profile was picked for goes
+ * out last. Returns 1 when the panel was adopted, 0 when it has
+ * to go through the full power on.
+ */
+static int icna3512_panel_adopt(struct icna3512_panel *icna3512)
+{
+	const struct icna3512_pwm_band *pwm;
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	struct device *dev = &dsi->dev;
+	unsigned long mode_flags = dsi->mode_flags;
+	u8 lit = MIPI_DCS_POWER_MODE_SLEEP | MIPI_DCS_POWER_MODE_DISPLAY;
+	u8 power_mode = 0;
+	int ret;
+
+	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+	ret = mipi_dsi_dcs_get_power_mode(dsi, &power_mode);
+	dsi->mode_flags = mode_flags;
+
+	if (ret < 0 || (power_mode & lit) != lit) {
+		dev_info(dev, "panel not running (%d, power mode %02x), resetting\n",
+			 ret, power_mode);
+		return 0;
+	}
+
+	dev_info(dev, "adopting panel lit by the firmware (power mode %02x)\n",
+		 power_mode);
+
+	icna3512_stamp(icna3512, ICNA3512_STAGE_RESET);
+
+	if (!icna3512->id_read)
+		icna3512_panel_identify(icna3512);
+
+	icna3512_cmd_run(icna3512);
+	// same as a full power on: the mode KMS is committing wins
+	icna3512_take_drm_mode(icna3512);
+
+	pwm = icna3512_pwm_stage(icna3512);
+
+	ret = icna3512_broadcast(icna3512, icna3512_link_adopt);
+	if (ret < 0)
+		return ret;
+
+	icna3512_pwm_commit(icna3512, pwm);
+
+	ret = icna3512_panel_upload_gamma(icna3512);
+	if (ret < 0)
+		return ret;
+
+	icna3512_stamp(icna3512, ICNA3512_STAGE_INIT);
+	icna3512_stamp(icna3512, ICNA3512_STAGE_SLPOUT);
+
+	ret = icna3512_panel_apply_ip(icna3512);
+	if (ret < 0)
+		return ret;
+
+	// the firmware's level is unknown, the profile above is for ours
+	ret = icna3512_panel_write_dbv(icna3512);
+	if (ret < 0)
+		return ret;
+
+	return 1;
+}
+
+static int icna3512_link_pwm(struct icna3512_panel *icna3512,
+			     struct mipi_dsi_device *dsi)
+{
+	unsigned long mode_flags = dsi->mode_flags;
+	int ret;
+
+	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+	ret = icna3512_write_pwm(icna3512, dsi);
+	dsi->mode_flags = mode_flags;
+
+	return ret;
+}
+
+/*
+ * Second half of a staged init. Queued at the end of prepare, so it gets
+ * the lock once prepare returns and streams the tables while the host
+ * starts sending video. A gamma set the panel already holds is skipped
+ * by the cache.
+ */
+static void icna3512_tables_work_fn(struct work_struct *work)
+{
+	struct icna3512_panel *icna3512 = container_of(work, struct icna3512_panel,
+						       tables_work);
+	struct device *dev = &icna3512->dsi->dev;
+	const struct icna3512_pwm_band *pwm;
+	int ret = 0;
+
+	mutex_lock(&icna3512->lock);
+
+	if (!icna3512->prepared)
+		goto unlock;
+
+	pwm = icna3512_pwm_stage(icna3512);
+	if (pwm) {
+		ret = icna3512_broadcast(icna3512, icna3512_link_pwm);
+		if (ret < 0)
+			goto unlock;
+
+		icna3512_pwm_commit(icna3512, pwm);
+	}
+
+	ret = icna3512_panel_upload_gamma(icna3512);
+	if (ret < 0)
+		goto unlock;
+
+	ret = icna3512_panel_apply_ip(icna3512);
+
+	icna3512->tables_ts = ktime_get();
+
+unlock:
+	mutex_unlock(&icna3512->lock);
+
+	if (ret < 0)
+		dev_err(dev, "failed to stream init tables: %d\n", ret);
+
+	complete_all(&icna3512->tables_done);
+}
+
+/* Barrier for callers that need the tables of a staged init in place */
+static int icna3512_panel_wait_tables(struct icna3512_panel *icna3512)
+{
+	if (!wait_for_completion_timeout(&icna3512->tables_done,
+					 msecs_to_jiffies(1000)))
+		return -ETIMEDOUT;
+
+	return 0;
+}
+
+static int icna3512_panel_disable(struct drm_panel *panel)
+{
+	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+
+	if (!icna3512->enabled)
+		return 0;
+
+	backlight_disable(icna3512->backlight);
+
+	icna3512->enabled = false;
+
+	return 0;
+}
+
+/*
+ * While the debugfs power bench runs, DRM's prepare fails with -EBUSY and
+ * its unprepare is a no-op; only the bench (bench = true) gets through.
+ */
+static int __icna3512_panel_unprepare(struct drm_panel *panel, bool bench)
+{
+	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	struct device *dev = &icna3512->dsi->dev;
+	int ret;
+
+	mutex_lock(&icna3512->lock);
+
+	if (!icna3512->prepared || icna3512->benching != bench)
+		goto unlock;
+
+	icna3512_panel_off(icna3512);
+
+	ret = regulator_bulk_disable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
+	if (ret < 0)
+		dev_err(dev, "regulator disable failed, %d\n", ret);
+
+	gpiod_set_value_cansleep(icna3512->reset_gpio, 1);
+
+	gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 0);
+
+	icna3512->gamma = NULL;
+	memset(icna3512->pwm_live, 0, sizeof(icna3512->pwm_live));
+	icna3512->ip_live_valid = 0;
+	icna3512->prepared = false;
+
+	if (icna3512->id_desc)
+		schedule_work(&icna3512->desc_work);
+
+unlock:
+	mutex_unlock(&icna3512->lock);
+
+	return 0;
+}
+
+static int icna3512_panel_unprepare(struct drm_panel *panel)
+{
+	return __icna3512_panel_unprepare(panel, false);
+}
+
+static int __icna3512_panel_prepare(struct drm_panel *panel, bool bench)
+{
+	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	struct device *dev = &icna3512->dsi->dev;
+	int ret, err;
+
+	mutex_lock(&icna3512->lock);
+
+	if (icna3512->relinking || icna3512->benching != bench) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	if (icna3512->prepared) {
+		ret = 0;
+		goto unlock;
+	}
+
+    // // csvke: Set the prepare_prev_first flag to ensure DSI interface is in LP-11 mode, https://forums.raspberrypi.com/viewtopic.php?p=2276942&hilit=LP+11#p2276316
+    // icna3512->base.prepare_prev_first = true;
+    // dev_info(dev, "Set panel prepare_prev_first to true\n");
+
+	icna3512_stamp(icna3512, ICNA3512_STAGE_START);
+
+	ret = regulator_bulk_enable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
+	if (ret < 0) {
+		dev_err(dev, "regulator enable failed, %d\n", ret);
+		goto unlock;
+	}
+
+	icna3512_stamp(icna3512, ICNA3512_STAGE_REGULATOR);
+
+	icna3512_take_drm_mode(icna3512);
+
+	if (icna3512->boot_lit) {
+		icna3512->boot_lit = false;
+
+		ret = icna3512_panel_adopt(icna3512);
+		if (ret < 0) {
+			dev_err(dev, "failed to adopt panel: %d\n", ret);
+			goto poweroff;
+		}
+		if (ret)
+			goto on;
+	}
+
+	gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 1);
+    usleep_range(10, 20);
+
+	// Trigger the reset pin according to the datasheet
+    // Set nRESET to low for at least T1 (10ms)
+    dev_info(panel->dev, "Setting reset GPIO low for 10ms (T1)\n");
+    gpiod_set_value(icna3512->reset_gpio, 1);
+    usleep_range(10000, 11000); // Sleep for 10ms
+
+    // Set nRESET to high for at least T3 (3ms)
+    dev_info(panel->dev, "Setting reset GPIO high for 3ms (T3)\n");
+    gpiod_set_value(icna3512->reset_gpio, 0);
+    usleep_range(3000, 4000); // Sleep for 3ms
+
+    // Set nRESET to low for at least T4 (7ms)
+    dev_info(panel->dev, "Keeping reset GPIO low for 7ms (T4)\n");
+    gpiod_set_value(icna3512->reset_gpio, 1);
+    usleep_range(7000, 8000); // Sleep for 7ms
+
+    // Set nRESET to high
+    dev_info(panel->dev, "Setting reset GPIO high\n");
+    gpiod_set_value(icna3512->reset_gpio, 0);
+
+    // Set a delay of 15ms (T4)
+    usleep_range(15000, 16000); // Sleep for 15ms
+
+    icna3512_stamp(icna3512, ICNA3512_STAGE_RESET);
+
+    if (!icna3512->id_read)
+        icna3512_panel_identify(icna3512);
+
+    // requests posted while the panel was off go out with the init code
+    icna3512_cmd_run(icna3512);
+    // the mode KMS is committing wins over a queued preference
+    icna3512_take_drm_mode(icna3512);
+
+    ret = icna3512_panel_init(icna3512);
+    if (ret < 0) {
+        dev_err(dev, "failed to init panel: %d\n", ret);
+        goto poweroff;
+    }
+
+    if (!icna3512->staged) {
+        ret = icna3512_panel_apply_ip(icna3512);
+        if (ret < 0) {
+            dev_err(dev, "failed to set IP blocks: %d\n", ret);
+            goto poweroff;
+        }
+    }
+
+    ret = icna3512_panel_on(icna3512);
+    if (ret < 0) {
+        dev_err(dev, "failed to set panel on: %d\n", ret);
+        goto poweroff;
+    }
+
+on:
+    icna3512_stamp(icna3512, ICNA3512_STAGE_DISPON);
+
+    icna3512->prepared = true;
+
+    if (icna3512->staged) {
+        reinit_completion(&icna3512->tables_done);
+        queue_work(system_highpri_wq, &icna3512->tables_work);
+    } else {
+        icna3512->tables_ts = icna3512->stage_ts[ICNA3512_STAGE_DISPON];
+    }
+
+    mutex_unlock(&icna3512->lock);
+
+    return 0;
+
+poweroff:
+    err = regulator_bulk_disable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
+    if (err < 0)
+        dev_err(dev, "regulator disable failed, %d\n", err);
+
+    gpiod_set_value_cansleep(icna3512->reset_gpio, 1);
+
+    gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 0);
+
+    icna3512->gamma = NULL;
+    memset(icna3512->pwm_live, 0, sizeof(icna3512->pwm_live));
+    icna3512->ip_live_valid = 0;
+
+unlock:
+    mutex_unlock(&icna3512->lock);
+
+    return ret;
+}
+
+static int icna3512_panel_prepare(struct drm_panel *panel)
+{
+	return __icna3512_panel_prepare(panel, false);
+}
+
+static int icna3512_panel_enable(struct drm_panel *panel)
+{
+	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	
+	if (icna3512->enabled)
+		return 0;
+
+	backlight_enable(icna3512->backlight);
+
+	icna3512->enabled = true;
+
+	return 0;
+}
+
+static int icna3512_panel_get_modes(struct drm_panel *panel, struct drm_connector *connector)
+{
+	struct drm_display_mode *mode;
+	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	static const u32 bus_format_30 = MEDIA_BUS_FMT_RGB101010_1X30;
+	static const u32 bus_format_24 = MEDIA_BUS_FMT_RGB888_1X24;
+	struct device *dev = &icna3512->dsi->dev;
+	const struct icna3512_mode *preferred;
+	unsigned int i;
+	int count = 0;
+	int ret;
+
+	icna3512->connector = connector;
+	preferred = icna3512_pick_mode(icna3512, icna3512->req_hz);
+
+	for (i = 0; i < icna3512->desc->num_modes; i++) {
+		const struct drm_display_mode *m = &icna3512->desc->modes[i].mode;
+
+		if (!icna3512_mode_offered(icna3512, &icna3512->desc->modes[i]))
+			continue;
+
+		mode = drm_mode_duplicate(connector->dev, m);
+		if (!mode) {
+			dev_err(dev, "failed to add mode %ux%ux@%u\n",
+				m->hdisplay, m->vdisplay, drm_mode_vrefresh(m));
+			return -ENOMEM;
+		}
+
+		drm_mode_set_name(mode);
+
+		mode->type = DRM_MODE_TYPE_DRIVER;
+		if (&icna3512->desc->modes[i] == preferred)
+			mode->type |= DRM_MODE_TYPE_PREFERRED;
+
+		drm_mode_probed_add(connector, mode);
+		count++;
+	}
+
+	connector->display_info.width_mm = 87;
+	connector->display_info.height_mm = 155;
+	connector->display_info.bpc = icna3512->bpc;
+
+	ret = drm_display_info_set_bus_formats(&connector->display_info,
+					       icna3512->bpc == 10 ? &bus_format_30 :
+								     &bus_format_24, 1);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+static int icna3512_cooling_get_max_state(struct thermal_cooling_device *cdev,
+					  unsigned long *state)
+{
+	*state = ARRAY_SIZE(icna3512_cooling) - 1;
+
+	return 0;
+}
+
+static int icna3512_cooling_get_cur_state(struct thermal_cooling_device *cdev,
+					  unsigned long *state)
+{
+	struct icna3512_panel *icna3512 = cdev->devdata;
+
+	*state = READ_ONCE(icna3512->cooling_state);
+
+	return 0;
+}
+
+static int icna3512_cooling_set_cur_state(struct thermal_cooling_device *cdev,
+					  unsigned long state)
+{
+	struct icna3512_panel *icna3512 = cdev->devdata;
+
+	if (state >= ARRAY_SIZE(icna3512_cooling))
+		return -EINVAL;
+
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_COOLING, state);
+
+	return 0;
+}
+
+static const struct thermal_cooling_device_ops icna3512_cooling_ops = {
+	.get_max_state = icna3512_cooling_get_max_state,
+	.get_cur_state = icna3512_cooling_get_cur_state,
+	.set_cur_state = icna3512_cooling_set_cur_state,
+};
+
+static ssize_t refresh_rate_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%d\n", drm_mode_vrefresh(&icna3512->mode->mode));
+}
+
+/*
+ * The write only records a preference: the closest mode offered to KMS is
+ * marked preferred and a hotplug event has userspace re-probe, the panel
+ * switches when a modeset picks that mode. Read refresh_rate back for the
+ * rate the panel runs.
+ */
+static ssize_t refresh_rate_store(struct device *dev,
+				  struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+	unsigned int rate;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &rate);
+	if (ret)
+		return ret;
+
+	if (!rate)
+		return -EINVAL;
+
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_RATE, rate);
+
+	return count;
+}
+static DEVICE_ATTR_RW(refresh_rate);
+
+static ssize_t panel_id_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+	ssize_t ret;
+
+	mutex_lock(&icna3512->lock);
+	if (icna3512->id_valid)
+		ret = sysfs_emit(buf, "%02x%02x%02x %s\n", icna3512->id[0],
+				 icna3512->id[1], icna3512->id[2],
+				 icna3512->desc->name);
+	else
+		ret = sysfs_emit(buf, "unknown %s\n", icna3512->desc->name);
+	mutex_unlock(&icna3512->lock);
+
+	return ret;
+}
+static DEVICE_ATTR_RO(panel_id);
+
+static int icna3512_ip_index(struct device_attribute *attr)
+{
+	unsigned int i;
+
+	for (i = 0; i < ICNA3512_NUM_IP; i++)
+		if (!strcmp(attr->attr.name, icna3512_ip_blocks[i].name))
+			return i;
+
+	return -EINVAL;
+}
+
+static ssize_t icna3512_ip_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+	int i = icna3512_ip_index(attr);
+	ssize_t ret;
+
+	mutex_lock(&icna3512->lock);
+	if (!test_bit(i, &icna3512->ip_set))
+		ret = sysfs_emit(buf, "otp\n");
+	else
+		ret = sysfs_emit(buf, "%d\n", test_bit(i, &icna3512->ip_want));
+	mutex_unlock(&icna3512->lock);
+
+	return ret;
+}
+
+/*
+ * A manual setting takes the blocks off the power source policy. Only the
+ * block's own bit is posted, on top of whatever was asked for last.
+ */
+static ssize_t icna3512_ip_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+	int i = icna3512_ip_index(attr);
+	bool on;
+	int ret;
+
+	ret = kstrtobool(buf, &on);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(icna3512->ip_auto, false);
+
+	icna3512_cmd_post_bits(icna3512, ICNA3512_CMD_IP, BIT(i), on ? BIT(i) : 0);
+
+	return count;
+}
+
+static DEVICE_ATTR(dtr, 0644, icna3512_ip_show, icna3512_ip_store);
+static DEVICE_ATTR(demura, 0644, icna3512_ip_show, icna3512_ip_store);
+static DEVICE_ATTR(sharpness, 0644, icna3512_ip_show, icna3512_ip_store);
+
+static ssize_t ip_policy_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n", READ_ONCE(icna3512->ip_auto) ? "auto" : "manual");
+}
+
+static ssize_t ip_policy_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+
+	if (sysfs_streq(buf, "auto"))
+		WRITE_ONCE(icna3512->ip_auto, true);
+	else if (sysfs_streq(buf, "manual"))
+		WRITE_ONCE(icna3512->ip_auto, false);
+	else
+		return -EINVAL;
+
+	if (icna3512->ip_auto)
+		schedule_work(&icna3512->ip_work);
+
+	return count;
+}
+static DEVICE_ATTR_RW(ip_policy);
+
+/* measured cost of the blocks currently switched on, from chipone,ip-power-mw */
+static ssize_t ip_power_mw_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct icna3512_panel *icna3512 = dev_get_drvdata(dev);
+	unsigned long on;
+	unsigned int i;
+	u32 mw = 0;
+
+	mutex_lock(&icna3512->lock);
+	on = icna3512->ip_set ? icna3512->ip_want : GENMASK(ICNA3512_NUM_IP - 1, 0);
+	for_each_set_bit(i, &on, ICNA3512_NUM_IP)
+		mw += icna3512->ip_power_mw[i];
+	mutex_unlock(&icna3512->lock);
+
+	return sysfs_emit(buf, "%u\n", mw);
+}
+static DEVICE_ATTR_RO(ip_power_mw);
+
+static struct attribute *icna3512_attrs[] = {
+	&dev_attr_refresh_rate.attr,
+	&dev_attr_panel_id.attr,
+	&dev_attr_dtr.attr,
+	&dev_attr_demura.attr,
+	&dev_attr_sharpness.attr,
+	&dev_attr_ip_policy.attr,
+	&dev_attr_ip_power_mw.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(icna3512);
+
+static int dsi_dcs_bl_get_brightness(struct backlight_device *bl)
+{
+	struct icna3512_panel *icna3512 = bl_get_data(bl);
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	unsigned long mode_flags;
+	int ret;
+	u16 brightness = bl->props.brightness;
+
+	// read back behind whatever is still queued
+	flush_work(&icna3512->cmd_work);
+
+	mutex_lock(&icna3512->lock);
+
+	mode_flags = dsi->mode_flags;
+	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+
+	ret = mipi_dsi_dcs_get_display_brightness_large(dsi, &brightness);
+
+	dsi->mode_flags = mode_flags;
+
+	if (ret >= 0)
+		ret = brightness & ICNA3512_DBV_MAX;
+
+	mutex_unlock(&icna3512->lock);
+
+	return ret;
+}
+
+static int dsi_dcs_bl_update_status(struct backlight_device *bl)
+{
+	struct icna3512_panel *icna3512 = bl_get_data(bl);
+
+	icna3512_cmd_post(icna3512, ICNA3512_CMD_BRIGHTNESS, bl->props.brightness);
+
+	return 0;
+}
+
+static const struct backlight_ops dsi_bl_ops = {
+	.update_status = dsi_dcs_bl_update_status,
+	.get_brightness = dsi_dcs_bl_get_brightness,
+};
+
+static struct backlight_device *
+drm_panel_create_dsi_backlight(struct icna3512_panel *icna3512)
+{
+	struct device *dev = &icna3512->dsi->dev;
+	struct backlight_properties props;
+
+	memset(&props, 0, sizeof(props));
+	props.type = BACKLIGHT_RAW;
+	props.brightness = ICNA3512_DBV_DEFAULT;
+	props.max_brightness = ICNA3512_DBV_MAX;
+
+	return devm_backlight_device_register(dev, dev_name(dev), dev, icna3512,
+					      &dsi_bl_ops, &props);
+}
+
+/*
+ * debugfs benchmark: "power N" runs N prepare/enable/disable/unprepare
+ * cycles on a panel no CRTC drives and reports each stage, "brightness N"
+ * times N DBV write + readback round trips on the panel DRM has enabled.
+ * Results are read back from the file.
+ */
+#define ICNA3512_BENCH_MAX_RUNS		10000
+#define ICNA3512_BENCH_HIST		16
+
+enum icna3512_bench_col {
+	ICNA3512_BENCH_REGULATOR,
+	ICNA3512_BENCH_RESET,
+	ICNA3512_BENCH_INIT,
+	ICNA3512_BENCH_SLPOUT,
+	ICNA3512_BENCH_DISPON,
+	ICNA3512_BENCH_TABLES,
+	ICNA3512_BENCH_ENABLE,
+	ICNA3512_BENCH_DISABLE,
+	ICNA3512_BENCH_UNPREPARE,
+	ICNA3512_BENCH_NUM_COLS,
+};
+
+static const char * const icna3512_bench_col_names[] = {
+	[ICNA3512_BENCH_REGULATOR] = "regulator",
+	[ICNA3512_BENCH_RESET] = "reset",
+	[ICNA3512_BENCH_INIT] = "init",
+	[ICNA3512_BENCH_SLPOUT] = "slpout",
+	[ICNA3512_BENCH_DISPON] = "dispon",
+	[ICNA3512_BENCH_TABLES] = "tables",
+	[ICNA3512_BENCH_ENABLE] = "enable",
+	[ICNA3512_BENCH_DISABLE] = "disable",
+	[ICNA3512_BENCH_UNPREPARE] = "unprepare",
+};
+
+struct icna3512_bench_result {
+	const char *name;
+	u32 min, mean, p99, max;		/* us */
+	u32 hist[ICNA3512_BENCH_HIST];		/* log2(us) buckets */
+};
+
+struct icna3512_bench {
+	struct mutex lock;
+	const char *mode;
+	unsigned int runs;
+	int error;
+	unsigned int mismatches;
+	u64 rate;				/* round trips per second */
+	unsigned int num_results;
+	struct icna3512_bench_result results[ICNA3512_BENCH_NUM_COLS];
+};
+
+static int icna3512_bench_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void icna3512_bench_summarize(struct icna3512_bench_result *res,
+				     const char *name, u32 *samples,
+				     unsigned int n)
+{
+	u64 sum = 0;
+	unsigned int i;
+
+	memset(res, 0, sizeof(*res));
+	res->name = name;
+	if (!n)
+		return;
+
+	sort(samples, n, sizeof(*samples), icna3512_bench_cmp, NULL);
+
+	for (i = 0; i < n; i++) {
+		sum += samples[i];
+		res->hist[min_t(unsigned int, fls(samples[i]), ICNA3512_BENCH_HIST - 1)]++;
+	}
+
+	res->min = samples[0];
+	res->max = samples[n - 1];
+	res->mean = div_u64(sum, n);
+	res->p99 = samples[DIV_ROUND_UP(n * 99, 100) - 1];
+}
+
+static u32 icna3512_bench_us(ktime_t end, ktime_t start)
+{
+	return ktime_us_delta(end, start);
+}
+
+static int icna3512_bench_power(struct icna3512_panel *icna3512,
+				struct icna3512_bench *bench, unsigned int runs)
+{
+	struct drm_panel *panel = &icna3512->base;
+	unsigned int i, col;
+	ktime_t t0, t1;
+	u32 *samples;
+	int ret = 0;
+
+	samples = kvcalloc(runs * ICNA3512_BENCH_NUM_COLS, sizeof(*samples), GFP_KERNEL);
+	if (!samples)
+		return -ENOMEM;
+
+	// the power is DRM's as soon as a CRTC drives the panel, keep it out
+	// of prepare/unprepare until the last cycle is done
+	mutex_lock(&icna3512->lock);
+	if (icna3512->prepared ||
+	    (icna3512->connector && icna3512->connector->state &&
+	     icna3512->connector->state->crtc))
+		ret = -EBUSY;
+	else
+		icna3512->benching = true;
+	mutex_unlock(&icna3512->lock);
+	if (ret) {
+		kvfree(samples);
+		return ret;
+	}
+
+	for (i = 0; i < runs; i++) {
+		u32 *s = &samples[i];
+
+		ret = __icna3512_panel_prepare(panel, true);
+		if (ret < 0)
+			break;
+
+		for (col = ICNA3512_BENCH_REGULATOR; col <= ICNA3512_BENCH_DISPON; col++)
+			s[col * runs] = icna3512_bench_us(icna3512->stage_ts[col + 1],
+							  icna3512->stage_ts[col]);
+
+		// time the staged tables take after DISP ON, 0 without staging
+		ret = icna3512_panel_wait_tables(icna3512);
+		if (ret < 0)
+			break;
+
+		s[ICNA3512_BENCH_TABLES * runs] =
+			icna3512_bench_us(icna3512->tables_ts,
+					  icna3512->stage_ts[ICNA3512_STAGE_DISPON]);
+
+		// enable and disable only post the DBV, time it reaching the panel
+		t0 = ktime_get();
+		icna3512_panel_enable(panel);
+		flush_work(&icna3512->cmd_work);
+		t1 = ktime_get();
+		s[ICNA3512_BENCH_ENABLE * runs] = icna3512_bench_us(t1, t0);
+
+		icna3512_panel_disable(panel);
+		flush_work(&icna3512->cmd_work);
+		t0 = ktime_get();
+		s[ICNA3512_BENCH_DISABLE * runs] = icna3512_bench_us(t0, t1);
+
+		__icna3512_panel_unprepare(panel, true);
+		t1 = ktime_get();
+		s[ICNA3512_BENCH_UNPREPARE * runs] = icna3512_bench_us(t1, t0);
+	}
+
+	// a failed cycle can leave the panel up, don't hand it to DRM that way
+	icna3512_panel_disable(panel);
+	__icna3512_panel_unprepare(panel, true);
+
+	mutex_lock(&icna3512->lock);
+	icna3512->benching = false;
+	// a lot switch the cycles above found had to wait for us
+	if (icna3512->id_desc)
+		schedule_work(&icna3512->desc_work);
+	mutex_unlock(&icna3512->lock);
+
+	bench->runs = i;
+	bench->num_results = ICNA3512_BENCH_NUM_COLS;
+	for (col = 0; col < ICNA3512_BENCH_NUM_COLS; col++)
+		icna3512_bench_summarize(&bench->results[col],
+					 icna3512_bench_col_names[col],
+					 &samples[col * runs], i);
+
+	kvfree(samples);
+
+	return ret;
+}
+
+static int icna3512_bench_brightness(struct icna3512_panel *icna3512,
+				     struct icna3512_bench *bench, unsigned int runs)
+{
+	struct backlight_device *bl = icna3512->backlight;
+	int brightness = bl->props.brightness;
+	ktime_t start, t0;
+	unsigned int i;
+	u32 *samples;
+	int ret = 0;
+
+	// only against the live panel, the power stays DRM's
+	mutex_lock(&icna3512->lock);
+	if (!icna3512->prepared || !icna3512->enabled)
+		ret = -ENODEV;
+	mutex_unlock(&icna3512->lock);
+	if (ret)
+		return ret;
+
+	samples = kvcalloc(runs, sizeof(*samples), GFP_KERNEL);
+	if (!samples)
+		return -ENOMEM;
+
+	// the readback is two bytes, the IC returns one after reset
+	ret = mipi_dsi_set_maximum_return_packet_size(icna3512->dsi, 2);
+	if (ret < 0)
+		goto out;
+
+	bench->mismatches = 0;
+	start = ktime_get();
+
+	for (i = 0; i < runs; i++) {
+		int val = i % bl->props.max_brightness + 1;
+
+		t0 = ktime_get();
+
+		ret = backlight_device_set_brightness(bl, val);
+		if (ret < 0)
+			break;
+
+		ret = bl->ops->get_brightness(bl);
+		if (ret < 0)
+			break;
+
+		samples[i] = icna3512_bench_us(ktime_get(), t0);
+
+		if (ret != val)
+			bench->mismatches++;
+		ret = 0;
+	}
+
+	bench->rate = i ? div64_u64((u64)i * NSEC_PER_SEC,
+				    max_t(s64, ktime_to_ns(ktime_sub(ktime_get(), start)), 1)) : 0;
+	bench->runs = i;
+	bench->num_results = 1;
+	icna3512_bench_summarize(&bench->results[0], "roundtrip", samples, i);
+
+	backlight_device_set_brightness(bl, brightness);
+
+out:
+	kvfree(samples);
+
+	return ret;
+}
+
+static int icna3512_bench_show(struct seq_file *s, void *data)
+{
+	struct icna3512_panel *icna3512 = s->private;
+	struct icna3512_bench *bench = icna3512->bench;
+	unsigned int i, j;
+
+	mutex_lock(&bench->lock);
+
+	if (!bench->mode) {
+		seq_puts(s, "usage: echo \"power|brightness <runs>\" > bench\n");
+		goto unlock;
+	}
+
+	seq_printf(s, "mode: %s, runs: %u, error: %d\n", bench->mode, bench->runs,
+		   bench->error);
+	if (bench->rate)
+		seq_printf(s, "rate: %llu/s, readback mismatches: %u\n", bench->rate,
+			   bench->mismatches);
+
+	seq_printf(s, "%-10s %8s %8s %8s %8s  (us)\n", "stage", "min", "mean", "p99", "max");
+	for (i = 0; i < bench->num_results; i++) {
+		const struct icna3512_bench_result *res = &bench->results[i];
+
+		seq_printf(s, "%-10s %8u %8u %8u %8u\n", res->name, res->min,
+			   res->mean, res->p99, res->max);
+	}
+
+	seq_puts(s, "histogram, log2(us) buckets\n");
+	for (i = 0; i < bench->num_results; i++) {
+		const struct icna3512_bench_result *res = &bench->results[i];
+
+		seq_printf(s, "%-10s", res->name);
+		for (j = 0; j < ICNA3512_BENCH_HIST; j++)
+			seq_printf(s, " %u", res->hist[j]);
+		seq_putc(s, '\n');
+	}
+
+unlock:
+	mutex_unlock(&bench->lock);
+
+	return 0;
+}
+
+static int icna3512_bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, icna3512_bench_show, inode->i_private);
+}
+
+static ssize_t icna3512_bench_write(struct file *file, const char __user *ubuf,
+				    size_t count, loff_t *ppos)
 {
-	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	struct icna3512_panel *icna3512 = file_inode(file)->i_private;
+	struct icna3512_bench *bench = icna3512->bench;
+	char buf[32], mode[16];
+	unsigned int runs;
+	int ret;
 
-	if (!icna3512->enabled)
-		return 0;
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%15s %u", mode, &runs) != 2 || !runs ||
+	    runs > ICNA3512_BENCH_MAX_RUNS)
+		return -EINVAL;
+
+	mutex_lock(&bench->lock);
+
+	if (!strcmp(mode, "power")) {
+		bench->mode = "power";
+		bench->rate = 0;
+		ret = icna3512_bench_power(icna3512, bench, runs);
+	} else if (!strcmp(mode, "brightness")) {
+		bench->mode = "brightness";
+		ret = icna3512_bench_brightness(icna3512, bench, runs);
+	} else {
+		ret = -EINVAL;
+	}
 
-	backlight_disable(icna3512->backlight);
+	if (ret != -EINVAL)
+		bench->error = ret;
 
-	icna3512->enabled = false;
+	mutex_unlock(&bench->lock);
 
-	return 0;
+	return ret < 0 ? ret : count;
 }
 
-static int icna3512_panel_unprepare(struct drm_panel *panel)
+static const struct file_operations icna3512_bench_fops = {
+	.owner = THIS_MODULE,
+	.open = icna3512_bench_open,
+	.read = seq_read,
+	.write = icna3512_bench_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void icna3512_bist_work_fn(struct work_struct *work)
 {
-	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
+	struct icna3512_panel *icna3512 = container_of(to_delayed_work(work),
+						       struct icna3512_panel,
+						       bist_work);
 	struct device *dev = &icna3512->dsi->dev;
+	const struct icna3512_bist_step *step;
 	int ret;
 
-	if (!icna3512->prepared)
-		return 0;
+	mutex_lock(&icna3512->lock);
 
-	icna3512_panel_off(icna3512);
+	if (!icna3512->bist_running)
+		goto unlock;
 
-	ret = regulator_bulk_disable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
-	if (ret < 0)
-		dev_err(dev, "regulator disable failed, %d\n", ret);
+	// DRM switched the panel off under us
+	if (!icna3512->prepared || !icna3512->enabled) {
+		icna3512->bist_running = false;
+		goto unlock;
+	}
 
-	gpiod_set_value_cansleep(icna3512->reset_gpio, 1);
+	step = &icna3512->bist_steps[icna3512->bist_cur];
+	ret = icna3512_panel_bist(icna3512, true, step->pattern);
+	if (ret < 0) {
+		dev_err(dev, "failed to show BIST pattern %06x: %d\n",
+			step->pattern, ret);
+		icna3512->bist_running = false;
+		goto unlock;
+	}
 
-	gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 0);
+	// a single pattern just stays up
+	if (icna3512->bist_num > 1)
+		queue_delayed_work(system_wq, &icna3512->bist_work,
+				   msecs_to_jiffies(step->dwell_ms));
 
-	icna3512->prepared = false;
+	if (++icna3512->bist_cur == icna3512->bist_num) {
+		icna3512->bist_cur = 0;
+		icna3512->bist_rounds++;
+	}
 
-	return 0;
+unlock:
+	mutex_unlock(&icna3512->lock);
 }
 
-static int icna3512_panel_prepare(struct drm_panel *panel)
+static void icna3512_bist_stop(struct icna3512_panel *icna3512)
 {
-	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
 	struct device *dev = &icna3512->dsi->dev;
 	int ret;
 
-	if (icna3512->prepared)
-		return 0;
+	mutex_lock(&icna3512->lock);
 
-    // // csvke: Set the prepare_prev_first flag to ensure DSI interface is in LP-11 mode, https://forums.raspberrypi.com/viewtopic.php?p=2276942&hilit=LP+11#p2276316
-    // icna3512->base.prepare_prev_first = true;
-    // dev_info(dev, "Set panel prepare_prev_first to true\n");
-	
-	ret = regulator_bulk_enable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
-	if (ret < 0) {
-		dev_err(dev, "regulator enable failed, %d\n", ret);
-		return ret;
+	if (icna3512->bist_running && icna3512->prepared) {
+		ret = icna3512_panel_bist(icna3512, false, 0);
+		if (ret < 0)
+			dev_err(dev, "failed to leave BIST: %d\n", ret);
 	}
 
-	gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 1);
-    usleep_range(10, 20);
-
-	// Trigger the reset pin according to the datasheet
-    // Set nRESET to low for at least T1 (10ms)
-    dev_info(panel->dev, "Setting reset GPIO low for 10ms (T1)\n");
-    gpiod_set_value(icna3512->reset_gpio, 1);
-    usleep_range(10000, 11000); // Sleep for 10ms
-
-    // Set nRESET to high for at least T3 (3ms)
-    dev_info(panel->dev, "Setting reset GPIO high for 3ms (T3)\n");
-    gpiod_set_value(icna3512->reset_gpio, 0);
-    usleep_range(3000, 4000); // Sleep for 3ms
+	icna3512->bist_running = false;
 
-    // Set nRESET to low for at least T4 (7ms)
-    dev_info(panel->dev, "Keeping reset GPIO low for 7ms (T4)\n");
-    gpiod_set_value(icna3512->reset_gpio, 1);
-    usleep_range(7000, 8000); // Sleep for 7ms
+	mutex_unlock(&icna3512->lock);
 
-    // Set nRESET to high
-    dev_info(panel->dev, "Setting reset GPIO high\n");
-    gpiod_set_value(icna3512->reset_gpio, 0);
+	cancel_delayed_work_sync(&icna3512->bist_work);
+}
 
-    // Set a delay of 15ms (T4)
-    usleep_range(15000, 16000); // Sleep for 15ms
+/*
+ * Only on a panel DRM prepared and enabled: the DSI host is only up inside
+ * the DRM pipeline, and the power stays DRM's to switch.
+ */
+static int icna3512_bist_start(struct icna3512_panel *icna3512,
+			       const struct icna3512_bist_step *steps,
+			       unsigned int num)
+{
+	int ret = 0;
 
-    ret = icna3512_panel_init(icna3512);
-    if (ret < 0) {
-        dev_err(dev, "failed to init panel: %d\n", ret);
-        goto poweroff;
-    }
+	icna3512_bist_stop(icna3512);
 
-    // ret = icna3512_panel_bist_test(icna3512->dsi);
-    // if (ret < 0) {
-    //     dev_err(dev, "failed to send BIST command: %d\n", ret);
-    //     goto poweroff;
-    // }
+	mutex_lock(&icna3512->lock);
 
-    ret = icna3512_panel_on(icna3512);
-    if (ret < 0) {
-        dev_err(dev, "failed to set panel on: %d\n", ret);
-        goto poweroff;
-    }
+	if (!icna3512->prepared || !icna3512->enabled) {
+		ret = -ENODEV;
+		goto unlock;
+	}
 
-    icna3512->prepared = true;
+	memcpy(icna3512->bist_steps, steps, num * sizeof(*steps));
+	icna3512->bist_num = num;
+	icna3512->bist_cur = 0;
+	icna3512->bist_rounds = 0;
+	icna3512->bist_running = true;
 
-    return 0;
+	queue_delayed_work(system_wq, &icna3512->bist_work, 0);
 
-poweroff:
-    ret = regulator_bulk_disable(ARRAY_SIZE(icna3512->supplies), icna3512->supplies);
-    if (ret < 0)
-        dev_err(dev, "regulator disable failed, %d\n", ret);
+unlock:
+	mutex_unlock(&icna3512->lock);
 
-    gpiod_set_value_cansleep(icna3512->reset_gpio, 1);
+	return ret;
+}
 
-    gpiod_set_value_cansleep(icna3512->dcdc_en_gpio, 0);
+/* "<pattern>[@<ms>] ...", pattern in hex */
+static int icna3512_bist_parse(char *buf, struct icna3512_bist_step *steps)
+{
+	unsigned int num = 0;
+	char *tok, *ms;
+
+	while ((tok = strsep(&buf, " \t\n"))) {
+		if (!*tok)
+			continue;
+		if (num == ICNA3512_BIST_MAX_STEPS)
+			return -E2BIG;
+
+		steps[num].dwell_ms = ICNA3512_BIST_DEF_DWELL_MS;
+		ms = strchr(tok, '@');
+		if (ms) {
+			*ms++ = '\0';
+			if (kstrtou32(ms, 0, &steps[num].dwell_ms) ||
+			    !steps[num].dwell_ms)
+				return -EINVAL;
+		}
+
+		if (kstrtou32(tok, 16, &steps[num].pattern) ||
+		    steps[num].pattern > 0xFFFFFF)
+			return -EINVAL;
+
+		num++;
+	}
 
-    return ret;
+	return num;
 }
 
-static int icna3512_panel_enable(struct drm_panel *panel)
+/*
+ * debugfs BIST: writing "001F01@2000 000001@500" cycles those patterns
+ * with their dwell times in ms, a bare "001F01" holds one, "on" holds
+ * the vendor pattern and "off" goes back to video.
+ */
+static int icna3512_bist_show(struct seq_file *s, void *data)
 {
-	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
-	
-	if (icna3512->enabled)
-		return 0;
+	struct icna3512_panel *icna3512 = s->private;
+	unsigned int i;
 
-	backlight_enable(icna3512->backlight);
+	mutex_lock(&icna3512->lock);
 
-	icna3512->enabled = true;
+	seq_printf(s, "state: %s, rounds: %u\n",
+		   icna3512->bist_running ? "running" : "off",
+		   icna3512->bist_rounds);
+	for (i = 0; i < icna3512->bist_num; i++)
+		seq_printf(s, "%06x@%u\n", icna3512->bist_steps[i].pattern,
+			   icna3512->bist_steps[i].dwell_ms);
+
+	mutex_unlock(&icna3512->lock);
 
 	return 0;
 }
 
-static const struct drm_display_mode default_mode = {
-        .clock		= 150000, // csvke
+static int icna3512_bist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, icna3512_bist_show, inode->i_private);
+}
+
+static ssize_t icna3512_bist_write(struct file *file, const char __user *ubuf,
+				   size_t count, loff_t *ppos)
+{
+	struct icna3512_panel *icna3512 = file_inode(file)->i_private;
+	struct icna3512_bist_step *steps;
+	char *buf;
+	int num, ret;
+
+	if (count > PAGE_SIZE)
+		return -EINVAL;
+
+	buf = memdup_user_nul(ubuf, count);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	if (sysfs_streq(buf, "off")) {
+		icna3512_bist_stop(icna3512);
+		ret = 0;
+		goto out;
+	}
+
+	steps = kcalloc(ICNA3512_BIST_MAX_STEPS, sizeof(*steps), GFP_KERNEL);
+	if (!steps) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	if (sysfs_streq(buf, "on")) {
+		steps[0].pattern = ICNA3512_BIST_DEF_PATTERN;
+		steps[0].dwell_ms = ICNA3512_BIST_DEF_DWELL_MS;
+		num = 1;
+	} else {
+		num = icna3512_bist_parse(buf, steps);
+	}
+
+	if (num > 0)
+		ret = icna3512_bist_start(icna3512, steps, num);
+	else
+		ret = num ?: -EINVAL;
+	kfree(steps);
+out:
+	kfree(buf);
 
-        .hdisplay	= 1080, // Hadr in datasheet
-        .hsync_start	= 1080 + 156, // HAdr + HFP
-        .hsync_end	= 1080 + 156 + 1, // HAdr + HFP + Hsync
-        .htotal		= 1080 + 156 + 1 + 23, // HAdr + HFP + Hsync + HBP
+	return ret < 0 ? ret : count;
+}
 
-        .vdisplay	= 1920, // VAdr in datasheet
-        .vsync_start	= 1920 + 20, // Vadr + VFP
-        .vsync_end	= 1920 + 20 + 1, // Vadr + VFP + Vsync
-        .vtotal		= 1920 + 20 + 1 + 15, // Vadr + VFP + Vsync + VBP
-		.flags = 0, // csvke: ??? maybe 0xA03
+static const struct file_operations icna3512_bist_fops = {
+	.owner = THIS_MODULE,
+	.open = icna3512_bist_open,
+	.read = seq_read,
+	.write = icna3512_bist_write,
+	.llseek = seq_lseek,
+	.release = single_release,
 };
 
-static int icna3512_panel_get_modes(struct drm_panel *panel, struct drm_connector *connector)
+static void icna3512_panel_debugfs_init(struct icna3512_panel *icna3512)
 {
-	struct drm_display_mode *mode;
-	struct icna3512_panel *icna3512 = to_icna3512_panel(panel);
 	struct device *dev = &icna3512->dsi->dev;
+	char name[48];
 
-	mode = drm_mode_duplicate(connector->dev, &default_mode);
-	if (!mode) {
-		dev_err(dev, "failed to add mode %ux%ux@%u\n",
-			default_mode.hdisplay, default_mode.vdisplay,
-			drm_mode_vrefresh(&default_mode));
-		return -ENOMEM;
-	}
+	icna3512->bench = devm_kzalloc(dev, sizeof(*icna3512->bench), GFP_KERNEL);
+	if (!icna3512->bench)
+		return;
 
-	drm_mode_set_name(mode);
+	mutex_init(&icna3512->bench->lock);
 
-	drm_mode_probed_add(connector, mode);
+	snprintf(name, sizeof(name), "icna3512-%s", dev_name(dev));
+	icna3512->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("bench", 0600, icna3512->debugfs, icna3512,
+			    &icna3512_bench_fops);
+	debugfs_create_file("bist", 0600, icna3512->debugfs, icna3512,
+			    &icna3512_bist_fops);
+}
 
-	connector->display_info.width_mm = 87;
-	connector->display_info.height_mm = 155;
+static const struct drm_panel_funcs icna3512_panel_funcs = {
+	.disable = icna3512_panel_disable,
+	.unprepare = icna3512_panel_unprepare,
+	.prepare = icna3512_panel_prepare,
+	.enable = icna3512_panel_enable,
+	.get_modes = icna3512_panel_get_modes,
+};
 
-	return 1;
+static const struct of_device_id icna3512_of_match[] = {
+    {
+        .compatible = "dxq,dxq7d0023",
+        .data = &dxq7d0023_desc,
+    },
+    {
+        .compatible = "gvo,g1700fh101gg",
+        .data = &g1700fh101gg_desc,
+    },
+    {
+        // lot picked from the DCS ID on the first prepare
+        .compatible = "chipone,icna3512",
+    },
+    { /* sentinel */ }
+};
+MODULE_DEVICE_TABLE(of, icna3512_of_match);
+
+/*
+ * Link budget from DT: "data-lanes" on the panel endpoint caps the lane
+ * count (4 when absent), "chipone,max-lane-mbps" is the host's per lane
+ * HS limit. Lanes are only traded for clock against a limit the host
+ * actually stated.
+ */
+static int icna3512_panel_plan_link(struct icna3512_panel *icna3512)
+{
+	struct device *dev = &icna3512->dsi->dev;
+	u32 mbps = ICNA3512_LANE_MBPS_MAX;
+	bool shrink;
+	int lanes;
+
+	lanes = drm_of_get_data_lanes_count_ep(dev->of_node, 0, -1, 1, 4);
+	if (lanes < 0)
+		lanes = 4;
+
+	shrink = !of_property_read_u32(dev->of_node, "chipone,max-lane-mbps", &mbps);
+	icna3512->lane_budget = mbps * 1000;
+
+	return icna3512_plan_lanes(icna3512, lanes, shrink);
 }
 
-static int dsi_dcs_bl_get_brightness(struct backlight_device *bl)
+static int icna3512_panel_attach(struct icna3512_panel *icna3512)
 {
-	struct mipi_dsi_device *dsi = bl_get_data(bl);
 	int ret;
-	u16 brightness = bl->props.brightness;
-
-	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
 
-	ret = mipi_dsi_dcs_get_display_brightness(dsi, &brightness);
+	ret = mipi_dsi_attach(icna3512->dsi);
 	if (ret < 0)
 		return ret;
 
-	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+	if (icna3512->dsi_sec) {
+		ret = mipi_dsi_attach(icna3512->dsi_sec);
+		if (ret < 0) {
+			mipi_dsi_detach(icna3512->dsi);
+			return ret;
+		}
+	}
 
-	return brightness & 0xff;
+	return 0;
 }
 
-static int dsi_dcs_bl_update_status(struct backlight_device *bl)
+static void icna3512_panel_detach(struct icna3512_panel *icna3512)
 {
-	struct mipi_dsi_device *dsi = bl_get_data(bl);
+	struct device *dev = &icna3512->dsi->dev;
 	int ret;
 
-	dsi->mode_flags &= ~MIPI_DSI_MODE_LPM;
+	if (icna3512->dsi_sec) {
+		ret = mipi_dsi_detach(icna3512->dsi_sec);
+		if (ret < 0)
+			dev_err(dev, "failed to detach second DSI link: %d\n",
+				ret);
+	}
 
-	ret = mipi_dsi_dcs_set_display_brightness(dsi, bl->props.brightness);
+	ret = mipi_dsi_detach(icna3512->dsi);
 	if (ret < 0)
-		return ret;
+		dev_err(dev, "failed to detach from DSI host: %d\n",
+			ret);
+}
 
-	dsi->mode_flags |= MIPI_DSI_MODE_LPM;
+/*
+ * Move to the mode table of the lot the ID pointed at. Called with the
+ * lock held and the links detached, the hosts take the new lane plan on
+ * the attach that follows.
+ */
+static void icna3512_panel_switch_desc(struct icna3512_panel *icna3512,
+				       const struct icna3512_panel_desc *desc)
+{
+	const struct icna3512_panel_desc *old = icna3512->desc;
+	const struct icna3512_mode *mode = icna3512->mode;
+	struct device *dev = &icna3512->dsi->dev;
+	int ret;
 
-	return 0;
-}
+	icna3512->desc = desc;
+	ret = icna3512_plan_lanes(icna3512, icna3512->max_lanes,
+				  icna3512->lane_shrink);
+	if (ret < 0) {
+		dev_warn(dev, "no %s mode fits the link, keeping %s\n",
+			 desc->name, old->name);
+		icna3512->desc = old;
+		icna3512->mode = mode;
+		icna3512_plan_lanes(icna3512, icna3512->max_lanes,
+				    icna3512->lane_shrink);
+		return;
+	}
 
-static const struct backlight_ops dsi_bl_ops = {
-	.update_status = dsi_dcs_bl_update_status,
-	.get_brightness = dsi_dcs_bl_get_brightness,
-};
+	icna3512->mode = icna3512_pick_mode(icna3512, icna3512->req_hz);
+}
 
-static struct backlight_device *
-drm_panel_create_dsi_backlight(struct mipi_dsi_device *dsi)
+/*
+ * Lot switch found by identify(), run once the panel is off. The links go
+ * down and come back with the new lane plan outside the panel lock, as a
+ * host may tear its DRM device down on detach and unprepare us; relinking
+ * keeps DRM's prepare out meanwhile. The hotplug event has userspace pick
+ * up the new mode list.
+ */
+static void icna3512_desc_work_fn(struct work_struct *work)
 {
-	struct device *dev = &dsi->dev;
-	struct backlight_properties props;
+	struct icna3512_panel *icna3512 = container_of(work, struct icna3512_panel,
+						       desc_work);
+	const struct icna3512_panel_desc *desc;
+	int ret;
 
-	memset(&props, 0, sizeof(props));
-	props.type = BACKLIGHT_RAW;
-	props.brightness = 255;
-	props.max_brightness = 255;
+	mutex_lock(&icna3512->lock);
+	desc = icna3512->id_desc;
+	// a prepare or the bench got in first, their unprepare queues us again
+	if (!desc || icna3512->prepared || icna3512->benching) {
+		mutex_unlock(&icna3512->lock);
+		return;
+	}
+	icna3512->id_desc = NULL;
+	icna3512->relinking = true;
+	mutex_unlock(&icna3512->lock);
 
-	return devm_backlight_device_register(dev, dev_name(dev), dev, dsi,
-					      &dsi_bl_ops, &props);
+	icna3512_panel_detach(icna3512);
+
+	mutex_lock(&icna3512->lock);
+	icna3512_panel_switch_desc(icna3512, desc);
+	mutex_unlock(&icna3512->lock);
+
+	ret = icna3512_panel_attach(icna3512);
+	if (ret < 0)
+		dev_err(&icna3512->dsi->dev, "failed to attach to DSI host: %d\n",
+			ret);
+
+	mutex_lock(&icna3512->lock);
+	icna3512->relinking = false;
+	mutex_unlock(&icna3512->lock);
+
+	schedule_work(&icna3512->hotplug_work);
 }
 
-static const struct drm_panel_funcs icna3512_panel_funcs = {
-	.disable = icna3512_panel_disable,
-	.unprepare = icna3512_panel_unprepare,
-	.prepare = icna3512_panel_prepare,
-	.enable = icna3512_panel_enable,
-	.get_modes = icna3512_panel_get_modes,
-};
+/*
+ * Whether the firmware may have left the panel running: supplies on,
+ * dcdc-en driven high and reset driven released. The IC itself is only
+ * asked on the first prepare, probe does not talk to the panel.
+ */
+static bool icna3512_panel_boot_lit(struct icna3512_panel *icna3512)
+{
+	unsigned int i;
 
-static const struct of_device_id icna3512_of_match[] = {
-    {
-        .compatible = "dxq,dxq7d0023",
-    },
-    { /* sentinel */ }
-};
-MODULE_DEVICE_TABLE(of, icna3512_of_match);
+	for (i = 0; i < ARRAY_SIZE(icna3512->supplies); i++)
+		if (regulator_is_enabled(icna3512->supplies[i].consumer) <= 0)
+			return false;
+
+	return gpiod_get_direction(icna3512->dcdc_en_gpio) == 0 &&
+	       gpiod_get_value_cansleep(icna3512->dcdc_en_gpio) == 1 &&
+	       gpiod_get_direction(icna3512->reset_gpio) == 0 &&
+	       gpiod_get_value_cansleep(icna3512->reset_gpio) == 0;
+}
 
 static int icna3512_panel_add(struct icna3512_panel *icna3512)
 {
+	struct thermal_cooling_device *cdev;
 	struct device *dev = &icna3512->dsi->dev;
 	int ret;
 	unsigned int i;
 
-	icna3512->mode = &default_mode;
+	icna3512->desc = of_device_get_match_data(dev);
+	icna3512->desc_fixed = !!icna3512->desc;
+	if (!icna3512->desc)
+		icna3512->desc = &dxq7d0023_desc;
+	icna3512->mode = &icna3512->desc->modes[0];
+	mutex_init(&icna3512->lock);
+
+	spin_lock_init(&icna3512->cmd_lock);
+	INIT_WORK(&icna3512->cmd_work, icna3512_cmd_work_fn);
+	INIT_WORK(&icna3512->hotplug_work, icna3512_hotplug_work_fn);
+	INIT_WORK(&icna3512->desc_work, icna3512_desc_work_fn);
+	// untouched blocks are pinned on, which is what the OTP code runs
+	icna3512->cmd_val[ICNA3512_CMD_IP] = GENMASK(ICNA3512_NUM_IP - 1, 0);
+	// ahead of the backlight and cooling device, which post to the queue
+	ret = devm_add_action_or_reset(dev, icna3512_cmd_cancel, icna3512);
+	if (ret < 0)
+		return ret;
+
+	ret = icna3512_panel_plan_link(icna3512);
+	if (ret < 0)
+		return ret;
+
+	icna3512->req_hz = drm_mode_vrefresh(&icna3512->mode->mode);
 
 	for (i = 0; i < ARRAY_SIZE(icna3512->supplies); i++)
 		icna3512->supplies[i].supply = regulator_names[i];
@@ -462,42 +3481,179 @@ static int icna3512_panel_add(struct icna3512_panel *icna3512)
 		return dev_err_probe(dev, ret,
 				     "failed to init regulator, ret=%d\n", ret);
 
-	icna3512->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
+	// left as is until we know whether the firmware has the panel up
+	icna3512->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_ASIS);
 	if (IS_ERR(icna3512->reset_gpio))
 		return dev_err_probe(dev, PTR_ERR(icna3512->reset_gpio),
 				     "cannot get reset-gpios %d\n", ret);
 
-	icna3512->dcdc_en_gpio = devm_gpiod_get(dev, "dcdc-en", GPIOD_OUT_LOW);
+	icna3512->dcdc_en_gpio = devm_gpiod_get(dev, "dcdc-en", GPIOD_ASIS);
 	if (IS_ERR(icna3512->dcdc_en_gpio))
 		return dev_err_probe(dev, PTR_ERR(icna3512->dcdc_en_gpio),
 				     "cannot get dcdc-en-gpio %d\n", ret);
 
-	icna3512->backlight = drm_panel_create_dsi_backlight(icna3512->dsi);
+	icna3512->boot_lit = icna3512_panel_boot_lit(icna3512);
+	if (!icna3512->boot_lit) {
+		gpiod_direction_output(icna3512->reset_gpio, 1);
+		gpiod_direction_output(icna3512->dcdc_en_gpio, 0);
+	}
+
+	icna3512->backlight = drm_panel_create_dsi_backlight(icna3512);
 	if (IS_ERR(icna3512->backlight))
 		return dev_err_probe(dev, PTR_ERR(icna3512->backlight),
 				     "failed to register backlight %d\n", ret);
+	icna3512->dbv = icna3512->backlight->props.brightness;
 
 	icna3512->base.prepare_prev_first = true;
 	drm_panel_init(&icna3512->base, &icna3512->dsi->dev, &icna3512_panel_funcs,
 		       DRM_MODE_CONNECTOR_DSI);
 
+	/* per block cost in mW, in enum icna3512_ip order, measured per lot */
+	of_property_read_u32_array(dev->of_node, "chipone,ip-power-mw",
+				   icna3512->ip_power_mw, ICNA3512_NUM_IP);
+
+	icna3512->staged = of_property_read_bool(dev->of_node, "chipone,staged-init");
+	INIT_WORK(&icna3512->tables_work, icna3512_tables_work_fn);
+	init_completion(&icna3512->tables_done);
+	complete_all(&icna3512->tables_done);
+
+	INIT_DELAYED_WORK(&icna3512->bist_work, icna3512_bist_work_fn);
+
+	icna3512->ip_auto = of_property_read_bool(dev->of_node, "chipone,ip-auto");
+	INIT_WORK(&icna3512->ip_work, icna3512_ip_work_fn);
+	icna3512->psy_nb.notifier_call = icna3512_psy_notify;
+	ret = power_supply_reg_notifier(&icna3512->psy_nb);
+	if (ret < 0)
+		return dev_err_probe(dev, ret, "failed to watch power supplies\n");
+
+	if (icna3512->ip_auto)
+		schedule_work(&icna3512->ip_work);
+
+	// optional, thermal zones refer to the panel node through #cooling-cells
+	cdev = devm_thermal_of_cooling_device_register(dev, dev->of_node,
+						       "icna3512", icna3512,
+						       &icna3512_cooling_ops);
+	if (IS_ERR(cdev))
+		dev_warn(dev, "no cooling device: %ld\n", PTR_ERR(cdev));
+
 	drm_panel_add(&icna3512->base);
 
+	icna3512_panel_debugfs_init(icna3512);
+
 	return 0;
 }
 
 static void icna3512_panel_del(struct icna3512_panel *icna3512)
 {
+	power_supply_unreg_notifier(&icna3512->psy_nb);
+	cancel_work_sync(&icna3512->ip_work);
+	cancel_work_sync(&icna3512->tables_work);
+	complete_all(&icna3512->tables_done);
+	cancel_delayed_work_sync(&icna3512->bist_work);
+
+	debugfs_remove_recursive(icna3512->debugfs);
+
 	if (icna3512->base.dev)
 		drm_panel_remove(&icna3512->base);
 }
 
+/*
+ * Pixel path from DT: "chipone,bpc" (8 or 10, default 8) and
+ * "chipone,dsc". 10bpc goes through the vendor's 10BIT_PPS_Table setup
+ * with DSC: two 540x20 slices per line, 3:1 down to bpc bits per pixel,
+ * the link format stays RGB888 and the host compresses from bpc. There
+ * is no vendor sequence for 30-bit video without DSC, so that is refused
+ * rather than sending the panel a format it was never set up for.
+ */
+static int icna3512_panel_get_format(struct icna3512_panel *icna3512)
+{
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	struct device *dev = &dsi->dev;
+	struct drm_dsc_config *dsc = &icna3512->dsc;
+	u32 bpc = 8;
+
+	of_property_read_u32(dev->of_node, "chipone,bpc", &bpc);
+	if (bpc != 8 && bpc != 10)
+		return dev_err_probe(dev, -EINVAL, "unsupported chipone,bpc %u\n", bpc);
+
+	icna3512->bpc = bpc;
+
+	if (!of_property_read_bool(dev->of_node, "chipone,dsc")) {
+		if (bpc == 10)
+			return dev_err_probe(dev, -EINVAL, "10bpc needs chipone,dsc\n");
+		return 0;
+	}
+
+	dsc->dsc_version_major = 1;
+	dsc->dsc_version_minor = 2;
+	dsc->pic_width = 1080;
+	dsc->pic_height = 1920;
+	dsc->slice_width = 540;
+	dsc->slice_height = 20;
+	dsc->slice_count = 2;
+	dsc->bits_per_component = bpc;
+	dsc->bits_per_pixel = bpc << 4;	/* U6.4 */
+	dsc->block_pred_enable = true;
+	dsc->convert_rgb = true;
+
+	dsi->dsc = dsc;
+
+	return 0;
+}
+
+/*
+ * Dual-DSI: port@1 of the panel node leads to the second DSI host. The
+ * panel is bound through the first one, the second link only gets a bare
+ * DSI device with the same lane and format setup.
+ */
+static int icna3512_panel_get_link(struct icna3512_panel *icna3512)
+{
+	struct mipi_dsi_device *dsi = icna3512->dsi;
+	struct device *dev = &dsi->dev;
+	const struct mipi_dsi_device_info info = {
+		.type = "icna3512-link1",
+		.channel = 0,
+		.node = NULL,
+	};
+	struct mipi_dsi_host *host;
+	struct device_node *np;
+
+	np = of_graph_get_remote_node(dev->of_node, 1, -1);
+	if (!np)
+		return 0;
+
+	host = of_find_mipi_dsi_host_by_node(np);
+	of_node_put(np);
+	if (!host)
+		return dev_err_probe(dev, -EPROBE_DEFER, "second DSI host not ready\n");
+
+	icna3512->dsi_sec = devm_mipi_dsi_device_register_full(dev, host, &info);
+	if (IS_ERR(icna3512->dsi_sec))
+		return dev_err_probe(dev, PTR_ERR(icna3512->dsi_sec),
+				     "failed to register second DSI link\n");
+
+	icna3512->dsi_sec->lanes = dsi->lanes;
+	icna3512->dsi_sec->format = dsi->format;
+	icna3512->dsi_sec->mode_flags = dsi->mode_flags;
+
+	// one 540 pixel half, so one slice per link
+	if (dsi->dsc) {
+		icna3512->dsc_sec = *dsi->dsc;
+		icna3512->dsc_sec.slice_count = 1;
+		icna3512->dsi_sec->dsc = &icna3512->dsc_sec;
+	}
+
+	dev_info(dev, "dual-DSI, second link on %s\n", dev_name(host->dev));
+
+	return 0;
+}
+
 static int icna3512_panel_probe(struct mipi_dsi_device *dsi)
 {
 	struct icna3512_panel *icna3512;
 	int ret;
 
-	dsi->lanes = 4;
+	// lane count comes from icna3512_panel_plan_link()
 	dsi->format = MIPI_DSI_FMT_RGB888;
 	// dsi->mode_flags =  MIPI_DSI_MODE_VIDEO_HSE | MIPI_DSI_MODE_VIDEO |
 	// 		   MIPI_DSI_CLOCK_NON_CONTINUOUS;
@@ -513,17 +3669,28 @@ static int icna3512_panel_probe(struct mipi_dsi_device *dsi)
 
 	icna3512->dsi = dsi;
 
-	ret = icna3512_panel_add(icna3512);
+	ret = icna3512_panel_get_format(icna3512);
 	if (ret < 0)
 		return ret;
 
-	ret = mipi_dsi_attach(dsi);
-	if (ret < 0) {
-		icna3512_panel_del(icna3512);
+	ret = icna3512_panel_get_link(icna3512);
+	if (ret < 0)
 		return ret;
-	}
+
+	ret = icna3512_panel_add(icna3512);
+	if (ret < 0)
+		return ret;
+
+	ret = icna3512_panel_attach(icna3512);
+	if (ret < 0)
+		goto err_del;
 
 	return 0;
+
+err_del:
+	icna3512_panel_del(icna3512);
+
+	return ret;
 }
 
 static void icna3512_panel_remove(struct mipi_dsi_device *dsi)
@@ -531,14 +3698,15 @@ static void icna3512_panel_remove(struct mipi_dsi_device *dsi)
 	struct icna3512_panel *icna3512 = mipi_dsi_get_drvdata(dsi);
 	int ret;
 
+	icna3512_bist_stop(icna3512);
+	// the lot switch detaches and attaches the links itself
+	cancel_work_sync(&icna3512->desc_work);
+
 	ret = icna3512_panel_disable(&icna3512->base);
 	if (ret < 0)
 		dev_err(&dsi->dev, "failed to disable panel: %d\n", ret);
 
-	ret = mipi_dsi_detach(dsi);
-	if (ret < 0)
-		dev_err(&dsi->dev, "failed to detach from DSI host: %d\n",
-			ret);
+	icna3512_panel_detach(icna3512);
 
 	icna3512_panel_del(icna3512);
 }
@@ -554,6 +3722,7 @@ static struct mipi_dsi_driver icna3512_panel_driver = {
 	.driver = {
 		.name = "panel-chipone-icna3512",
 		.of_match_table = icna3512_of_match,
+		.dev_groups = icna3512_groups,
 	},
 	.probe = icna3512_panel_probe,
 	.remove = icna3512_panel_remove,
@@ -564,3 +3733,7 @@ module_mipi_dsi_driver(icna3512_panel_driver);
 MODULE_AUTHOR("Frankie Yuen <frankie.yuen@me.com>");
 MODULE_DESCRIPTION("Chipone ICNA3512 AMOLED Display Driver IC");
 MODULE_LICENSE("GPL v2");
+
+#if IS_ENABLED(CONFIG_DRM_PANEL_CHIPONE_ICNA3512_KUNIT_TEST)
+#include "panel-chipone-icna3512-test.c"
+#endif
@@ -0,0 +1,420 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Software stand-in for an FT5x06 touch controller on an I2C bus.
+ *
+ * Registers an I2C adapter with one "edt-ft5506" client behind it, so
+ * edt-ft5x06 binds as it would on real hardware. Behind the adapter sits
+ * a register model of an EDT M09 controller: identification, the
+ * configuration registers and a touch report area fed by a scripted
+ * drag. One finger moves across the panel for drag_ms, then lifts for
+ * gap_ms, with a new report every 1/rate_hz. Every transfer is charged
+ * the wire time at scl_hz, so the driver can be timed end to end on any
+ * machine.
+ *
+ * With CONFIG_IRQ_SIM each report raises a simulated interrupt, so the
+ * driver runs its hard IRQ path. Otherwise the client has no IRQ and the
+ * driver polls.
+ *
+ *	make MOCK=1
+ *	insmod edt-ft5x06.ko
+ *	insmod edt-ft5x06-mock.ko rate_hz=120 scl_hz=400000
+ *
+ * Report and bus statistics are in debugfs under edt-ft5x06-mock/.
+ * Writing to the stats file clears the counters.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/i2c.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/irq_sim.h>
+#include <linux/irqdomain.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#define EDT_MOCK_NAME			"edt-ft5x06-mock"
+#define EDT_MOCK_CLIENT			"edt-ft5506"
+#define EDT_MOCK_ADDR			0x38
+
+#define EDT_MOCK_VENDOR_M09		0x50	/* EP0500M09 */
+#define EDT_MOCK_REG_VENDOR		0xa8
+#define EDT_MOCK_REG_FW			0xa6
+#define EDT_MOCK_REG_NUM_X		0x94
+#define EDT_MOCK_REG_NUM_Y		0x95
+#define EDT_MOCK_TD_STATUS		0x02
+#define EDT_MOCK_POINT			0x03
+
+#define EDT_MOCK_EVENT_DOWN		0x00
+#define EDT_MOCK_EVENT_UP		0x01
+#define EDT_MOCK_EVENT_ON		0x02
+
+static unsigned int rate_hz = 120;
+module_param(rate_hz, uint, 0444);
+MODULE_PARM_DESC(rate_hz, "touch report rate while a finger is down (Hz)");
+
+static unsigned int drag_ms = 500;
+module_param(drag_ms, uint, 0644);
+MODULE_PARM_DESC(drag_ms, "length of one scripted drag (ms)");
+
+static unsigned int gap_ms = 250;
+module_param(gap_ms, uint, 0644);
+MODULE_PARM_DESC(gap_ms, "pause between drags, no finger down (ms)");
+
+static unsigned int scl_hz = 400000;
+module_param(scl_hz, uint, 0644);
+MODULE_PARM_DESC(scl_hz, "I2C clock the transfers are charged at (Hz)");
+
+static bool use_irq = true;
+module_param(use_irq, bool, 0444);
+MODULE_PARM_DESC(use_irq, "raise a simulated IRQ per report, needs CONFIG_IRQ_SIM");
+
+/* 17 x 30 sensors, 64 positions each, 1088 x 1920 */
+static unsigned int num_x = 17;
+module_param(num_x, uint, 0444);
+MODULE_PARM_DESC(num_x, "sensor columns reported to the driver");
+
+static unsigned int num_y = 30;
+module_param(num_y, uint, 0444);
+MODULE_PARM_DESC(num_y, "sensor rows reported to the driver");
+
+struct edt_mock_stats {
+	u64 reports;
+	u64 irqs;
+	u64 xfers;
+	u64 bytes;
+	u64 bus_ns;
+	u64 errors;
+};
+
+struct edt_mock {
+	struct i2c_adapter adap;
+	struct i2c_client *client;
+
+	struct irq_domain *irq_domain;
+	int irq;
+
+	struct hrtimer timer;
+	ktime_t period;
+	ktime_t drag_ts;
+	bool down;
+
+	struct dentry *debugfs;
+
+	/* registers and stats, taken by the report timer and the bus */
+	spinlock_t lock;
+	u8 regs[256];
+	u8 reg_ptr;
+	struct edt_mock_stats stats;
+};
+
+static struct edt_mock *edt_mock;
+
+static void edt_mock_set_point(struct edt_mock *mock, u8 event,
+			       unsigned int x, unsigned int y)
+{
+	u8 *p = &mock->regs[EDT_MOCK_POINT];
+
+	p[0] = event << 6 | (x >> 8 & 0x0f);
+	p[1] = x;
+	p[2] = y >> 8 & 0x0f;			/* touch id 0 */
+	p[3] = y;
+	p[4] = 0x40;				/* weight */
+	p[5] = 0x00;
+}
+
+/* one step of the scripted drag, a diagonal across the whole panel */
+static bool edt_mock_step(struct edt_mock *mock, ktime_t now)
+{
+	s64 elapsed = ktime_ms_delta(now, mock->drag_ts);
+	unsigned int max_x = num_x * 64 - 1, max_y = num_y * 64 - 1;
+	unsigned int x, y;
+
+	if (mock->down && elapsed >= drag_ms) {
+		/* lift: one UP report, then nothing to read */
+		mock->down = false;
+		mock->drag_ts = now;
+		mock->regs[EDT_MOCK_TD_STATUS] = 1;
+		mock->regs[EDT_MOCK_POINT] = EDT_MOCK_EVENT_UP << 6 |
+					     (mock->regs[EDT_MOCK_POINT] & 0x0f);
+		return true;
+	}
+
+	if (!mock->down) {
+		mock->regs[EDT_MOCK_TD_STATUS] = 0;
+		if (elapsed < gap_ms)
+			return false;
+
+		mock->down = true;
+		mock->drag_ts = now;
+		elapsed = 0;
+	}
+
+	x = div_u64((u64)max_x * elapsed, drag_ms ?: 1);
+	y = div_u64((u64)max_y * elapsed, drag_ms ?: 1);
+	mock->regs[EDT_MOCK_TD_STATUS] = 1;
+	edt_mock_set_point(mock, elapsed ? EDT_MOCK_EVENT_ON : EDT_MOCK_EVENT_DOWN,
+			   min(x, max_x), min(y, max_y));
+
+	return true;
+}
+
+static enum hrtimer_restart edt_mock_timer(struct hrtimer *t)
+{
+	struct edt_mock *mock = container_of(t, struct edt_mock, timer);
+	unsigned long flags;
+	bool report;
+
+	spin_lock_irqsave(&mock->lock, flags);
+	report = edt_mock_step(mock, ktime_get());
+	if (report) {
+		mock->stats.reports++;
+		if (mock->irq > 0)
+			mock->stats.irqs++;
+	}
+	spin_unlock_irqrestore(&mock->lock, flags);
+
+	if (report && mock->irq > 0)
+		irq_set_irqchip_state(mock->irq, IRQCHIP_STATE_PENDING, true);
+
+	hrtimer_forward_now(t, mock->period);
+
+	return HRTIMER_RESTART;
+}
+
+/* start, address and ack, then 9 clocks per byte */
+static u64 edt_mock_cost(const struct i2c_msg *msg)
+{
+	return div_u64((u64)(msg->len + 1) * 9 * NSEC_PER_SEC, scl_hz ?: 1);
+}
+
+static void edt_mock_spend(u64 ns)
+{
+	if (ns >= 10 * NSEC_PER_USEC)
+		fsleep(DIV_ROUND_UP_ULL(ns, NSEC_PER_USEC));
+	else
+		ndelay(ns);
+}
+
+/*
+ * FT5x06 register access: a write sets the register pointer and stores
+ * any data bytes from there, a read returns registers from the pointer
+ * on. Both auto-increment.
+ */
+static int edt_mock_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+	struct edt_mock *mock = i2c_get_adapdata(adap);
+	unsigned long flags;
+	u64 cost = 0;
+	int i, j;
+
+	for (i = 0; i < num; i++)
+		cost += edt_mock_cost(&msgs[i]);
+	edt_mock_spend(cost);
+
+	spin_lock_irqsave(&mock->lock, flags);
+
+	mock->stats.xfers++;
+	mock->stats.bus_ns += cost;
+
+	for (i = 0; i < num; i++) {
+		struct i2c_msg *msg = &msgs[i];
+
+		if (msg->addr != EDT_MOCK_ADDR) {
+			mock->stats.errors++;
+			spin_unlock_irqrestore(&mock->lock, flags);
+			return -ENXIO;
+		}
+
+		mock->stats.bytes += msg->len;
+
+		if (msg->flags & I2C_M_RD) {
+			for (j = 0; j < msg->len; j++)
+				msg->buf[j] = mock->regs[mock->reg_ptr++];
+		} else if (msg->len) {
+			mock->reg_ptr = msg->buf[0];
+			for (j = 1; j < msg->len; j++)
+				mock->regs[mock->reg_ptr++] = msg->buf[j];
+		}
+	}
+
+	spin_unlock_irqrestore(&mock->lock, flags);
+
+	return num;
+}
+
+static u32 edt_mock_func(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm edt_mock_algo = {
+	.master_xfer = edt_mock_xfer,
+	.functionality = edt_mock_func,
+};
+
+static int edt_mock_stats_show(struct seq_file *s, void *data)
+{
+	struct edt_mock *mock = s->private;
+	struct edt_mock_stats st;
+
+	spin_lock_irq(&mock->lock);
+	st = mock->stats;
+	spin_unlock_irq(&mock->lock);
+
+	seq_printf(s, "reports:     %llu\n", st.reports);
+	seq_printf(s, "irqs:        %llu\n", st.irqs);
+	seq_printf(s, "transfers:   %llu\n", st.xfers);
+	seq_printf(s, "bytes:       %llu\n", st.bytes);
+	seq_printf(s, "bus time:    %llu us\n", div_u64(st.bus_ns, NSEC_PER_USEC));
+	seq_printf(s, "errors:      %llu\n", st.errors);
+
+	return 0;
+}
+
+static int edt_mock_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edt_mock_stats_show, inode->i_private);
+}
+
+static ssize_t edt_mock_stats_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct edt_mock *mock = file_inode(file)->i_private;
+
+	spin_lock_irq(&mock->lock);
+	memset(&mock->stats, 0, sizeof(mock->stats));
+	spin_unlock_irq(&mock->lock);
+
+	return count;
+}
+
+static const struct file_operations edt_mock_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = edt_mock_stats_open,
+	.read = seq_read,
+	.write = edt_mock_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int edt_mock_add_irq(struct edt_mock *mock)
+{
+	if (!IS_ENABLED(CONFIG_IRQ_SIM) || !use_irq)
+		return 0;
+
+	mock->irq_domain = irq_domain_create_sim(NULL, 1);
+	if (IS_ERR(mock->irq_domain))
+		return PTR_ERR(mock->irq_domain);
+
+	mock->irq = irq_create_mapping(mock->irq_domain, 0);
+	if (!mock->irq) {
+		irq_domain_remove_sim(mock->irq_domain);
+		return -ENXIO;
+	}
+
+	// the driver falls back to falling edge without a trigger type
+	irq_set_irq_type(mock->irq, IRQ_TYPE_EDGE_FALLING);
+
+	return 0;
+}
+
+static void edt_mock_del_irq(struct edt_mock *mock)
+{
+	if (!IS_ENABLED(CONFIG_IRQ_SIM) || !mock->irq_domain)
+		return;
+
+	irq_dispose_mapping(mock->irq);
+	irq_domain_remove_sim(mock->irq_domain);
+}
+
+static int __init edt_mock_init(void)
+{
+	struct i2c_board_info info = {
+		I2C_BOARD_INFO(EDT_MOCK_CLIENT, EDT_MOCK_ADDR),
+	};
+	struct edt_mock *mock;
+	int ret;
+
+	if (!rate_hz || !num_x || !num_y || num_x > 255 || num_y > 255)
+		return -EINVAL;
+
+	mock = kzalloc(sizeof(*mock), GFP_KERNEL);
+	if (!mock)
+		return -ENOMEM;
+
+	spin_lock_init(&mock->lock);
+	mock->regs[EDT_MOCK_REG_VENDOR] = EDT_MOCK_VENDOR_M09;
+	mock->regs[EDT_MOCK_REG_FW] = 0x01;
+	mock->regs[EDT_MOCK_REG_NUM_X] = num_x;
+	mock->regs[EDT_MOCK_REG_NUM_Y] = num_y;
+
+	ret = edt_mock_add_irq(mock);
+	if (ret)
+		goto err_free;
+
+	mock->adap.owner = THIS_MODULE;
+	mock->adap.algo = &edt_mock_algo;
+	strscpy(mock->adap.name, EDT_MOCK_NAME, sizeof(mock->adap.name));
+	i2c_set_adapdata(&mock->adap, mock);
+
+	ret = i2c_add_adapter(&mock->adap);
+	if (ret)
+		goto err_irq;
+
+	mock->debugfs = debugfs_create_dir(EDT_MOCK_NAME, NULL);
+	debugfs_create_file("stats", 0644, mock->debugfs, mock, &edt_mock_stats_fops);
+
+	// reports start flowing before the driver binds, as on real hardware
+	mock->period = ns_to_ktime(div_u64(NSEC_PER_SEC, rate_hz));
+	mock->drag_ts = ktime_get();
+	hrtimer_init(&mock->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	mock->timer.function = edt_mock_timer;
+	hrtimer_start(&mock->timer, mock->period, HRTIMER_MODE_REL);
+
+	edt_mock = mock;
+
+	info.irq = mock->irq;
+	mock->client = i2c_new_client_device(&mock->adap, &info);
+	if (IS_ERR(mock->client)) {
+		ret = PTR_ERR(mock->client);
+		goto err_timer;
+	}
+
+	dev_info(&mock->adap.dev, "%s at 0x%02x, %u Hz, %s\n", EDT_MOCK_CLIENT,
+		 EDT_MOCK_ADDR, rate_hz, mock->irq > 0 ? "simulated IRQ" : "polled");
+
+	return 0;
+
+err_timer:
+	hrtimer_cancel(&mock->timer);
+	debugfs_remove_recursive(mock->debugfs);
+	i2c_del_adapter(&mock->adap);
+err_irq:
+	edt_mock_del_irq(mock);
+err_free:
+	kfree(mock);
+
+	return ret;
+}
+module_init(edt_mock_init);
+
+static void __exit edt_mock_exit(void)
+{
+	struct edt_mock *mock = edt_mock;
+
+	i2c_unregister_device(mock->client);
+	hrtimer_cancel(&mock->timer);
+	debugfs_remove_recursive(mock->debugfs);
+	i2c_del_adapter(&mock->adap);
+	edt_mock_del_irq(mock);
+	kfree(mock);
+}
+module_exit(edt_mock_exit);
+
+MODULE_AUTHOR("Frankie Yuen <frankie.yuen@me.com>");
+MODULE_DESCRIPTION("FT5x06 touch controller mock on a fake I2C adapter");
+MODULE_LICENSE("GPL v2");
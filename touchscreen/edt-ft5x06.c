@@ -16,21 +16,28 @@
 
 #include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/freezer.h>
 #include <linux/gpio/consumer.h>
+#include <linux/hrtimer.h>
 #include <linux/i2c.h>
 #include <linux/interrupt.h>
 #include <linux/input.h>
 #include <linux/input/mt.h>
 #include <linux/input/touchscreen.h>
 #include <linux/irq.h>
+#include <linux/kfifo.h>
 #include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/property.h>
 #include <linux/ratelimit.h>
+#include <linux/seq_file.h>
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
 
 #include <asm/unaligned.h>
 
@@ -75,6 +82,8 @@
 #define EDT_RAW_DATA_RETRIES		100
 #define EDT_RAW_DATA_DELAY		1000 /* usec */
 
+#define EDT_MAX_TDATA_LEN		63	/* 10 points of 6 bytes + header */
+
 #define EDT_DEFAULT_NUM_X		1024
 #define EDT_DEFAULT_NUM_Y		1024
 
@@ -83,7 +92,19 @@
 
 #define RESET_DELAY_MS			300	/* reset deassert to I2C */
 #define FIRST_POLL_DELAY_MS		300	/* in addition to the above */
-#define POLL_INTERVAL_MS		17	/* 17ms = 60fps */
+#define POLL_MIN_US			8000	/* 125Hz while touched */
+#define POLL_MAX_US			136000	/* idle backoff limit */
+#define POLL_LIMIT_LOW_US		1000
+#define POLL_LIMIT_HIGH_US		1000000
+
+#define HYBRID_WINDOW_MS		100	/* IRQ rate sampling window */
+#define HYBRID_EXIT_MS			100
+#define HYBRID_LIMIT_HIGH_HZ		1000
+#define HYBRID_LIMIT_HIGH_MS		10000
+
+#define VSYNC_OFFSET_US			3000	/* read this far ahead of vsync */
+#define VSYNC_MIN_FRAME_US		2000
+#define VSYNC_MAX_FRAME_US		100000
 
 enum edt_pmode {
 	EDT_PMODE_NOT_SUPPORTED,
@@ -110,6 +131,67 @@ struct edt_reg_addr {
 	int reg_num_y;
 };
 
+/*
+ * One report in latency mode, as read from debugfs latency. Times are
+ * CLOCK_MONOTONIC and irq_ns is also the report's input timestamp, which
+ * is what joins a record to its evdev frame. edt-latency.c has a copy of
+ * this layout.
+ */
+struct edt_ft5x06_lat {
+	u32 seq;
+	u32 points;
+	u64 irq_ns;		/* IRQ edge, or start of a poll */
+	u64 thread_ns;		/* handler running */
+	u64 read_ns;		/* I2C read done */
+	u64 sync_ns;		/* input_sync() done */
+};
+
+#define EDT_LAT_RECORDS			4096
+
+/*
+ * Raw capture ring, mapped read-only through debugfs raw_ring: this header,
+ * then frames slots of frame_size bytes from data_offset on. Frame seq n
+ * lives in slot n % frames, its seq is 0 while the slot is being written.
+ * A reader takes head, copies that slot and keeps the copy if the slot's
+ * seq still matches afterwards.
+ */
+struct edt_ft5x06_raw_ring {
+	u32 frames;
+	u32 frame_size;
+	u32 data_offset;
+	u16 num_x;
+	u16 num_y;
+	u32 head;		/* newest complete frame, 0 before the first */
+	u32 errors;		/* failed scans, or not in factory mode */
+};
+
+struct edt_ft5x06_raw_frame {
+	u32 seq;
+	u32 reserved;
+	u64 ts_ns;		/* CLOCK_MONOTONIC, scan done */
+	u16 data[];		/* as in debugfs raw_data */
+};
+
+#define EDT_RAW_RING_FRAMES		64
+#define EDT_RAW_RING_IDLE_MS		100
+
+/*
+ * Per node raw statistics over the last complete window of captured frames,
+ * as read from debugfs stats_nodes. Means are in 1/256 counts, the baseline
+ * follows the window means with 1/8 weight.
+ */
+struct edt_ft5x06_node_stats {
+	u32 baseline;
+	u32 mean;
+	u32 var;		/* counts^2 */
+	u16 min;
+	u16 max;
+};
+
+#define EDT_STATS_WINDOW		64
+#define EDT_STATS_WINDOW_MAX		1024
+#define EDT_STATS_BASELINE_SHIFT	3
+
 struct edt_ft5x06_ts_data {
 	struct i2c_client *client;
 	struct input_dev *input;
@@ -121,6 +203,7 @@ struct edt_ft5x06_ts_data {
 
 	struct gpio_desc *reset_gpio;
 	struct gpio_desc *wake_gpio;
+	struct gpio_desc *vsync_gpio;
 
 	struct regmap *regmap;
 
@@ -128,6 +211,32 @@ struct edt_ft5x06_ts_data {
 	struct dentry *debug_dir;
 	u8 *raw_buffer;
 	size_t raw_bufsize;
+
+	/* latency mode: per report stage times, read from debugfs */
+	bool lat_on;
+	u32 lat_seq;
+	struct mutex lat_mutex;
+	DECLARE_KFIFO_PTR(lat_fifo, struct edt_ft5x06_lat);
+
+	/* raw capture: raw_task scans into raw_ring back to back */
+	struct edt_ft5x06_raw_ring *raw_ring;
+	size_t raw_ring_size;
+	struct task_struct *raw_task;
+	struct mutex raw_ring_mutex;
+
+	/*
+	 * Raw statistics: the capture thread accumulates stats_window frames
+	 * per node, then publishes them to stats and starts over.
+	 */
+	struct mutex stats_mutex;
+	unsigned int stats_window;
+	unsigned int stats_frames;
+	unsigned int stats_windows;
+	u32 *stats_sum;
+	u64 *stats_sumsq;
+	u16 *stats_min;
+	u16 *stats_max;
+	struct edt_ft5x06_node_stats *stats;
 #endif
 
 	struct mutex mutex;
@@ -155,17 +264,81 @@ struct edt_ft5x06_ts_data {
 	unsigned int crc_errors;
 	unsigned int header_errors;
 
-	struct timer_list timer;
+	/*
+	 * Polling without IRQ: every poll re-arms the timer, at poll_min_us
+	 * while a finger is down, doubling from there up to poll_max_us while
+	 * idle.
+	 */
+	struct hrtimer timer;
 	struct work_struct work_i2c_poll;
+	unsigned int poll_min_us;
+	unsigned int poll_max_us;
+	unsigned int poll_us;
+	bool poll_stopped;
+
+	/*
+	 * Hybrid mode: above hybrid_enter_hz interrupts the IRQ is masked and
+	 * the poller takes over at poll_min_us, until no finger was down for
+	 * hybrid_exit_ms. hybrid_enter_hz 0 keeps the IRQ at any rate.
+	 */
+	unsigned int hybrid_enter_hz;
+	unsigned int hybrid_exit_ms;
+	bool hybrid_polling;
+	ktime_t hybrid_active_ts;
+	ktime_t irq_window_ts;
+	unsigned int irq_count;
+
+	/*
+	 * Vsync lock: with a vsync (panel TE) line the poller does not
+	 * re-arm itself, each vsync edge schedules the next read
+	 * vsync_offset_us ahead of the following one instead.
+	 */
+	int vsync_irq;
+	unsigned int vsync_offset_us;
+	ktime_t vsync_ts;
+	s64 frame_us;
+	ktime_t sample_ts;
+
+	/* edge time of the report the threaded handler is reading */
+	ktime_t irq_ts;
+
+	/*
+	 * touch reports land here, DMA safe for the I2C adapter: nothing may
+	 * share its cache lines, so it stays the last member
+	 */
+	u8 tdata_buf[EDT_MAX_TDATA_LEN] __aligned(ARCH_DMA_MINALIGN);
 };
 
 struct edt_i2c_chip_data {
 	int  max_support_points;
 };
 
+/*
+ * Only the configuration registers are cached, for every layout the generic
+ * regmap serves. Touch data, mode and identification registers stay live.
+ */
+static bool edt_ft5x06_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case M09_REGISTER_THRESHOLD:
+	case M09_REGISTER_GAIN:
+	case M09_REGISTER_OFFSET:
+	case M12_REGISTER_REPORT_RATE:
+	case EV_REGISTER_THRESHOLD:
+	case EV_REGISTER_GAIN:
+	case EV_REGISTER_OFFSET_Y:
+	case EV_REGISTER_OFFSET_X:
+		return false;
+	default:
+		return true;
+	}
+}
+
 static const struct regmap_config edt_ft5x06_i2c_regmap_config = {
 	.reg_bits = 8,
 	.val_bits = 8,
+	.volatile_reg = edt_ft5x06_volatile_reg,
+	.cache_type = REGCACHE_MAPLE,
 };
 
 static bool edt_ft5x06_ts_check_crc(struct edt_ft5x06_ts_data *tsdata,
@@ -299,31 +472,170 @@ static int edt_M06_i2c_write(void *context, const void *data, size_t count)
 	return 0;
 }
 
+/*
+ * Work mode configuration registers. Factory mode reuses the addresses for
+ * other things, the raw scan trigger at 0x08 among them, so the cache is
+ * bypassed for as long as the controller is in factory mode.
+ */
+static bool edt_M06_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case WORK_REGISTER_THRESHOLD:
+	case WORK_REGISTER_REPORT_RATE:
+	case WORK_REGISTER_GAIN:
+	case WORK_REGISTER_OFFSET:
+		return false;
+	default:
+		return true;
+	}
+}
+
 static const struct regmap_config edt_M06_i2c_regmap_config = {
 	.reg_bits = 8,
 	.val_bits = 8,
+	.volatile_reg = edt_M06_volatile_reg,
+	.cache_type = REGCACHE_MAPLE,
 	.read = edt_M06_i2c_read,
 	.write = edt_M06_i2c_write,
 };
 
+/*
+ * Touch data read for the non-M06 controllers, straight to the adapter.
+ * Regmap adds nothing for these volatile registers but its own locking
+ * and formatting, and it stays in use for the configuration registers.
+ */
+static int edt_ft5x06_ts_read_tdata(struct edt_ft5x06_ts_data *tsdata,
+				    u8 addr, u8 *buf, int len)
+{
+	struct i2c_client *client = tsdata->client;
+	struct i2c_msg xfer[2];
+	int ret;
+
+	xfer[0].addr  = client->addr;
+	xfer[0].flags = 0;
+	xfer[0].len = 1;
+	xfer[0].buf = &addr;
+
+	xfer[1].addr = client->addr;
+	xfer[1].flags = I2C_M_RD | I2C_M_DMA_SAFE;
+	xfer[1].len = len;
+	xfer[1].buf = buf;
+
+	ret = i2c_transfer(client->adapter, xfer, 2);
+	if (ret != 2) {
+		if (ret < 0)
+			return ret;
+
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static irqreturn_t edt_ft5x06_ts_hardirq(int irq, void *dev_id)
+{
+	struct edt_ft5x06_ts_data *tsdata = dev_id;
+
+	tsdata->irq_ts = ktime_get();
+
+	return IRQ_WAKE_THREAD;
+}
+
+#ifdef CONFIG_DEBUG_FS
+static void edt_ft5x06_ts_lat_log(struct edt_ft5x06_ts_data *tsdata,
+				  ktime_t irq_ts, ktime_t thread_ts,
+				  ktime_t read_ts, int points)
+{
+	struct edt_ft5x06_lat lat;
+
+	if (!READ_ONCE(tsdata->lat_on))
+		return;
+
+	lat = (struct edt_ft5x06_lat) {
+		.seq = tsdata->lat_seq,
+		.points = points,
+		.irq_ns = ktime_to_ns(irq_ts),
+		.thread_ns = ktime_to_ns(thread_ts),
+		.read_ns = ktime_to_ns(read_ts),
+		.sync_ns = ktime_get_ns(),
+	};
+
+	/* a reader that falls behind loses records, seq shows the gap */
+	kfifo_put(&tsdata->lat_fifo, lat);
+	tsdata->lat_seq++;
+}
+#else
+static void edt_ft5x06_ts_lat_log(struct edt_ft5x06_ts_data *tsdata,
+				  ktime_t irq_ts, ktime_t thread_ts,
+				  ktime_t read_ts, int points)
+{
+}
+#endif
+
+/* called from the IRQ thread, hands a busy stream of reports to the poller */
+static void edt_ft5x06_ts_hybrid_check(struct edt_ft5x06_ts_data *tsdata,
+				       int irq)
+{
+	unsigned int enter_hz = READ_ONCE(tsdata->hybrid_enter_hz);
+	ktime_t now = tsdata->irq_ts;
+	s64 elapsed;
+	unsigned int rate;
+
+	if (!enter_hz)
+		return;
+
+	tsdata->irq_count++;
+	elapsed = ktime_ms_delta(now, tsdata->irq_window_ts);
+	if (elapsed < HYBRID_WINDOW_MS)
+		return;
+
+	rate = div64_s64(tsdata->irq_count * MSEC_PER_SEC, elapsed);
+	tsdata->irq_window_ts = now;
+	tsdata->irq_count = 0;
+
+	if (rate < enter_hz || !tsdata->known_ids)
+		return;
+
+	/* we run in this IRQ's thread, disable_irq() would wait for us */
+	tsdata->hybrid_polling = true;
+	tsdata->hybrid_active_ts = now;
+	disable_irq_nosync(irq);
+	hrtimer_start(&tsdata->timer,
+		      us_to_ktime(READ_ONCE(tsdata->poll_min_us)),
+		      HRTIMER_MODE_REL);
+}
+
 static irqreturn_t edt_ft5x06_ts_isr(int irq, void *dev_id)
 {
 	struct edt_ft5x06_ts_data *tsdata = dev_id;
 	struct device *dev = &tsdata->client->dev;
-	u8 rdbuf[63];
+	u8 *rdbuf = tsdata->tdata_buf;
 	int i, type, x, y, id;
 	int error;
-	int num_points;
+	int num_points, predicted;
 	unsigned int active_ids = 0, known_ids = tsdata->known_ids;
 	long released_ids;
 	int b = 0;
+	ktime_t start = ktime_get(), read_ts;
+	/* the polled report is as old as the start of the read */
+	ktime_t ts = irq ? tsdata->irq_ts : start;
 
-	memset(rdbuf, 0, sizeof(rdbuf));
-	error = regmap_bulk_read(tsdata->regmap, tsdata->tdata_cmd, rdbuf,
-				 tsdata->tdata_len);
+	memset(rdbuf, 0, sizeof(tsdata->tdata_buf));
 	if (tsdata->version == EDT_M06) {
+		error = regmap_bulk_read(tsdata->regmap, tsdata->tdata_cmd,
+					 rdbuf, tsdata->tdata_len);
 		num_points = tsdata->max_support_points;
 	} else {
+		/* Fetch the header and as many points as the previous report
+		 * had in one go, fingers rarely come or go between reports.
+		 * At least one, an interrupt means there is something to read.
+		 */
+		predicted = clamp_t(int, hweight32(known_ids), 1,
+				    tsdata->max_support_points);
+		error = edt_ft5x06_ts_read_tdata(tsdata, tsdata->tdata_cmd,
+						 rdbuf, tsdata->tdata_len +
+						 tsdata->point_len * predicted);
+
 		/* Register 2 is TD_STATUS, containing the number of touch
 		 * points.
 		 */
@@ -343,11 +655,16 @@ static irqreturn_t edt_ft5x06_ts_isr(int irq, void *dev_id)
 			tsdata->init_td_status = 0;
 		}
 
-		if (!error && num_points)
-			error = regmap_bulk_read(tsdata->regmap,
-						 tsdata->tdata_offset,
-						 &rdbuf[tsdata->tdata_offset],
-						 tsdata->point_len * num_points);
+		/* only a report with new fingers needs a second transfer */
+		if (!error && num_points > predicted) {
+			int offset = tsdata->tdata_offset +
+				     tsdata->point_len * predicted;
+
+			error = edt_ft5x06_ts_read_tdata(tsdata, offset,
+							 &rdbuf[offset],
+							 tsdata->point_len *
+							 (num_points - predicted));
+		}
 	}
 	if (error) {
 		dev_err_ratelimited(dev, "Unable to fetch data, error: %d\n",
@@ -355,6 +672,11 @@ static irqreturn_t edt_ft5x06_ts_isr(int irq, void *dev_id)
 		goto out;
 	}
 
+	read_ts = ktime_get();
+
+	/* events carry the contact time, not the end of the I2C read */
+	input_set_timestamp(tsdata->input, ts);
+
 	for (i = 0; i < num_points; i++) {
 		u8 *buf = &rdbuf[i * tsdata->point_len + tsdata->tdata_offset];
 
@@ -399,25 +721,139 @@ static irqreturn_t edt_ft5x06_ts_isr(int irq, void *dev_id)
 
 	input_mt_report_pointer_emulation(tsdata->input, true);
 	input_sync(tsdata->input);
+	edt_ft5x06_ts_lat_log(tsdata, ts, start, read_ts, num_points);
+
+	if (irq)
+		edt_ft5x06_ts_hybrid_check(tsdata, irq);
 
 out:
 	return IRQ_HANDLED;
 }
 
-static void edt_ft5x06_ts_irq_poll_timer(struct timer_list *t)
+static enum hrtimer_restart edt_ft5x06_ts_irq_poll_timer(struct hrtimer *t)
 {
-	struct edt_ft5x06_ts_data *tsdata = from_timer(tsdata, t, timer);
+	struct edt_ft5x06_ts_data *tsdata = container_of(t,
+			struct edt_ft5x06_ts_data, timer);
 
-	schedule_work(&tsdata->work_i2c_poll);
-	mod_timer(&tsdata->timer, jiffies + msecs_to_jiffies(POLL_INTERVAL_MS));
+	queue_work(system_highpri_wq, &tsdata->work_i2c_poll);
+
+	return HRTIMER_NORESTART;
 }
 
 static void edt_ft5x06_ts_work_i2c_poll(struct work_struct *work)
 {
 	struct edt_ft5x06_ts_data *tsdata = container_of(work,
 			struct edt_ft5x06_ts_data, work_i2c_poll);
+	unsigned int min_us = READ_ONCE(tsdata->poll_min_us);
+	unsigned int max_us = READ_ONCE(tsdata->poll_max_us);
 
+	WRITE_ONCE(tsdata->sample_ts, ktime_get());
 	edt_ft5x06_ts_isr(0, tsdata);
+
+	if (READ_ONCE(tsdata->poll_stopped))
+		return;
+
+	if (tsdata->hybrid_polling) {
+		ktime_t now = ktime_get();
+
+		if (tsdata->known_ids) {
+			tsdata->hybrid_active_ts = now;
+		} else if (ktime_ms_delta(now, tsdata->hybrid_active_ts) >=
+			   READ_ONCE(tsdata->hybrid_exit_ms)) {
+			/* the drag is over, back to interrupts */
+			tsdata->hybrid_polling = false;
+			tsdata->irq_window_ts = now;
+			tsdata->irq_count = 0;
+			enable_irq(tsdata->client->irq);
+			return;
+		}
+		tsdata->poll_us = min_us;
+	} else if (tsdata->known_ids) {
+		tsdata->poll_us = min_us;
+	} else {
+		tsdata->poll_us = clamp(tsdata->poll_us * 2, min_us, max_us);
+	}
+
+	/* the next vsync schedules the next read */
+	if (tsdata->vsync_irq)
+		return;
+
+	hrtimer_start(&tsdata->timer, us_to_ktime(tsdata->poll_us),
+		      HRTIMER_MODE_REL);
+}
+
+static irqreturn_t edt_ft5x06_ts_vsync_isr(int irq, void *dev_id)
+{
+	struct edt_ft5x06_ts_data *tsdata = dev_id;
+	ktime_t now = ktime_get();
+	s64 frame_us = ktime_us_delta(now, tsdata->vsync_ts);
+	s64 delay_us;
+
+	tsdata->vsync_ts = now;
+
+	/* first edge or a gap in the stream, nothing to predict from */
+	if (frame_us < VSYNC_MIN_FRAME_US || frame_us > VSYNC_MAX_FRAME_US)
+		return IRQ_HANDLED;
+
+	/* smoothed, so a late edge does not shift the next read */
+	if (tsdata->frame_us)
+		frame_us = (3 * tsdata->frame_us + frame_us) / 4;
+	tsdata->frame_us = frame_us;
+
+	/* the touch IRQ delivers reports unless hybrid mode polls */
+	if (READ_ONCE(tsdata->poll_stopped) ||
+	    (tsdata->client->irq && !READ_ONCE(tsdata->hybrid_polling)))
+		return IRQ_HANDLED;
+
+	/* a read is already due, the first one or a hybrid mode switch */
+	if (hrtimer_is_queued(&tsdata->timer))
+		return IRQ_HANDLED;
+
+	delay_us = max_t(s64, frame_us - READ_ONCE(tsdata->vsync_offset_us), 0);
+
+	/* idle backoff, skip frames until poll_us has passed */
+	if (ktime_us_delta(now, READ_ONCE(tsdata->sample_ts)) + delay_us +
+	    frame_us / 2 < READ_ONCE(tsdata->poll_us))
+		return IRQ_HANDLED;
+
+	hrtimer_start(&tsdata->timer, us_to_ktime(delay_us), HRTIMER_MODE_REL);
+
+	return IRQ_HANDLED;
+}
+
+static void edt_ft5x06_ts_stop_polling(struct edt_ft5x06_ts_data *tsdata)
+{
+	/* a running poll or vsync may still re-arm the timer once */
+	WRITE_ONCE(tsdata->poll_stopped, true);
+	if (tsdata->vsync_irq)
+		synchronize_irq(tsdata->vsync_irq);
+	cancel_work_sync(&tsdata->work_i2c_poll);
+	hrtimer_cancel(&tsdata->timer);
+	cancel_work_sync(&tsdata->work_i2c_poll);
+}
+
+/* give a hybrid mode poller's reports back to the IRQ */
+static void edt_ft5x06_ts_hybrid_leave(struct edt_ft5x06_ts_data *tsdata)
+{
+	int irq = tsdata->client->irq;
+
+	if (!irq)
+		return;
+
+	/*
+	 * The poll work may hand back to the IRQ itself, only look once it
+	 * is stopped so the IRQ is enabled exactly once.
+	 */
+	synchronize_irq(irq);
+	edt_ft5x06_ts_stop_polling(tsdata);
+	WRITE_ONCE(tsdata->poll_stopped, false);
+
+	if (!tsdata->hybrid_polling)
+		return;
+
+	tsdata->hybrid_polling = false;
+	tsdata->irq_count = 0;
+	enable_irq(irq);
 }
 
 struct edt_ft5x06_attribute {
@@ -640,6 +1076,174 @@ static ssize_t crc_errors_show(struct device *dev,
 
 static DEVICE_ATTR_RO(crc_errors);
 
+/* polling and hybrid mode, fastest interval while touched */
+static ssize_t poll_min_us_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+
+	return sysfs_emit(buf, "%u\n", tsdata->poll_min_us);
+}
+
+static ssize_t poll_min_us_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+	unsigned int val;
+	int error;
+
+	error = kstrtouint(buf, 0, &val);
+	if (error)
+		return error;
+
+	mutex_lock(&tsdata->mutex);
+
+	if (val < POLL_LIMIT_LOW_US || val > tsdata->poll_max_us)
+		error = -ERANGE;
+	else
+		WRITE_ONCE(tsdata->poll_min_us, val);
+
+	mutex_unlock(&tsdata->mutex);
+	return error ?: count;
+}
+
+static DEVICE_ATTR_RW(poll_min_us);
+
+/* polling only, slowest interval the idle backoff reaches */
+static ssize_t poll_max_us_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+
+	return sysfs_emit(buf, "%u\n", tsdata->poll_max_us);
+}
+
+static ssize_t poll_max_us_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+	unsigned int val;
+	int error;
+
+	error = kstrtouint(buf, 0, &val);
+	if (error)
+		return error;
+
+	mutex_lock(&tsdata->mutex);
+
+	if (val < tsdata->poll_min_us || val > POLL_LIMIT_HIGH_US)
+		error = -ERANGE;
+	else
+		WRITE_ONCE(tsdata->poll_max_us, val);
+
+	mutex_unlock(&tsdata->mutex);
+	return error ?: count;
+}
+
+static DEVICE_ATTR_RW(poll_max_us);
+
+/* IRQ rate that switches to polling, 0 never does */
+static ssize_t hybrid_enter_hz_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+
+	return sysfs_emit(buf, "%u\n", tsdata->hybrid_enter_hz);
+}
+
+static ssize_t hybrid_enter_hz_store(struct device *dev,
+				     struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+	unsigned int val;
+	int error;
+
+	error = kstrtouint(buf, 0, &val);
+	if (error)
+		return error;
+
+	if (val > HYBRID_LIMIT_HIGH_HZ)
+		return -ERANGE;
+
+	WRITE_ONCE(tsdata->hybrid_enter_hz, val);
+	return count;
+}
+
+static DEVICE_ATTR_RW(hybrid_enter_hz);
+
+/* time without a finger down before polling hands back to the IRQ */
+static ssize_t hybrid_exit_ms_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+
+	return sysfs_emit(buf, "%u\n", tsdata->hybrid_exit_ms);
+}
+
+static ssize_t hybrid_exit_ms_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+	unsigned int val;
+	int error;
+
+	error = kstrtouint(buf, 0, &val);
+	if (error)
+		return error;
+
+	if (!val || val > HYBRID_LIMIT_HIGH_MS)
+		return -ERANGE;
+
+	WRITE_ONCE(tsdata->hybrid_exit_ms, val);
+	return count;
+}
+
+static DEVICE_ATTR_RW(hybrid_exit_ms);
+
+/* vsync lock only, how long before the next vsync the report is read */
+static ssize_t vsync_offset_us_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+
+	return sysfs_emit(buf, "%u\n", tsdata->vsync_offset_us);
+}
+
+static ssize_t vsync_offset_us_store(struct device *dev,
+				     struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
+	unsigned int val;
+	int error;
+
+	error = kstrtouint(buf, 0, &val);
+	if (error)
+		return error;
+
+	if (val > VSYNC_MAX_FRAME_US)
+		return -ERANGE;
+
+	WRITE_ONCE(tsdata->vsync_offset_us, val);
+	return count;
+}
+
+static DEVICE_ATTR_RW(vsync_offset_us);
+
 static struct attribute *edt_ft5x06_attrs[] = {
 	&edt_ft5x06_attr_gain.dattr.attr,
 	&edt_ft5x06_attr_offset.dattr.attr,
@@ -651,6 +1255,11 @@ static struct attribute *edt_ft5x06_attrs[] = {
 	&dev_attr_fw_version.attr,
 	&dev_attr_header_errors.attr,
 	&dev_attr_crc_errors.attr,
+	&dev_attr_poll_min_us.attr,
+	&dev_attr_poll_max_us.attr,
+	&dev_attr_hybrid_enter_hz.attr,
+	&dev_attr_hybrid_exit_ms.attr,
+	&dev_attr_vsync_offset_us.attr,
 	NULL
 };
 
@@ -658,22 +1267,12 @@ static const struct attribute_group edt_ft5x06_attr_group = {
 	.attrs = edt_ft5x06_attrs,
 };
 
-static void edt_ft5x06_restore_reg_parameters(struct edt_ft5x06_ts_data *tsdata)
+/* write back the cached configuration after the controller lost it */
+static int edt_ft5x06_restore_reg_parameters(struct edt_ft5x06_ts_data *tsdata)
 {
-	struct edt_reg_addr *reg_addr = &tsdata->reg_addr;
-	struct regmap *regmap = tsdata->regmap;
+	regcache_mark_dirty(tsdata->regmap);
 
-	regmap_write(regmap, reg_addr->reg_threshold, tsdata->threshold);
-	regmap_write(regmap, reg_addr->reg_gain, tsdata->gain);
-	if (reg_addr->reg_offset != NO_REGISTER)
-		regmap_write(regmap, reg_addr->reg_offset, tsdata->offset);
-	if (reg_addr->reg_offset_x != NO_REGISTER)
-		regmap_write(regmap, reg_addr->reg_offset_x, tsdata->offset_x);
-	if (reg_addr->reg_offset_y != NO_REGISTER)
-		regmap_write(regmap, reg_addr->reg_offset_y, tsdata->offset_y);
-	if (reg_addr->reg_report_rate != NO_REGISTER)
-		regmap_write(regmap, reg_addr->reg_report_rate,
-			     tsdata->report_rate);
+	return regcache_sync(tsdata->regmap);
 }
 
 #ifdef CONFIG_DEBUG_FS
@@ -690,6 +1289,7 @@ static int edt_ft5x06_factory_mode(struct edt_ft5x06_ts_data *tsdata)
 		return -EINVAL;
 	}
 
+	edt_ft5x06_ts_hybrid_leave(tsdata);
 	disable_irq(client->irq);
 
 	if (!tsdata->raw_buffer) {
@@ -711,6 +1311,7 @@ static int edt_ft5x06_factory_mode(struct edt_ft5x06_ts_data *tsdata)
 	}
 
 	tsdata->factory_mode = true;
+	regcache_cache_bypass(tsdata->regmap, true);
 	do {
 		mdelay(EDT_SWITCH_MODE_DELAY);
 		/* mode register is 0x01 when in factory mode */
@@ -733,6 +1334,7 @@ err_out:
 	kfree(tsdata->raw_buffer);
 	tsdata->raw_buffer = NULL;
 	tsdata->factory_mode = false;
+	regcache_cache_bypass(tsdata->regmap, false);
 	enable_irq(client->irq);
 
 	return error;
@@ -773,7 +1375,11 @@ static int edt_ft5x06_work_mode(struct edt_ft5x06_ts_data *tsdata)
 	kfree(tsdata->raw_buffer);
 	tsdata->raw_buffer = NULL;
 
-	edt_ft5x06_restore_reg_parameters(tsdata);
+	regcache_cache_bypass(tsdata->regmap, false);
+	error = edt_ft5x06_restore_reg_parameters(tsdata);
+	if (error)
+		dev_warn(&client->dev,
+			 "failed to restore registers, error %d\n", error);
 	enable_irq(client->irq);
 
 	return 0;
@@ -811,44 +1417,36 @@ static int edt_ft5x06_debugfs_mode_set(void *data, u64 mode)
 DEFINE_SIMPLE_ATTRIBUTE(debugfs_mode_fops, edt_ft5x06_debugfs_mode_get,
 			edt_ft5x06_debugfs_mode_set, "%llu\n");
 
-static ssize_t edt_ft5x06_debugfs_raw_data_read(struct file *file,
-						char __user *buf, size_t count,
-						loff_t *off)
+/*
+ * Scan one raw frame into buf, num_x columns of num_y nodes, and stamp the
+ * end of the scan into ts if given. Called with tsdata->mutex held and the
+ * controller in factory mode.
+ */
+static int edt_ft5x06_raw_scan(struct edt_ft5x06_ts_data *tsdata, u8 *buf,
+			       u64 *ts)
 {
-	struct edt_ft5x06_ts_data *tsdata = file->private_data;
 	struct i2c_client *client = tsdata->client;
 	int retries  = EDT_RAW_DATA_RETRIES;
 	unsigned int val;
 	int i, error;
-	size_t read = 0;
 	int colbytes;
-	u8 *rdbuf;
-
-	if (*off < 0 || *off >= tsdata->raw_bufsize)
-		return 0;
-
-	mutex_lock(&tsdata->mutex);
-
-	if (!tsdata->factory_mode || !tsdata->raw_buffer) {
-		error = -EIO;
-		goto out;
-	}
 
 	error = regmap_write(tsdata->regmap, 0x08, 0x01);
 	if (error) {
-		dev_err(&client->dev,
-			"failed to write 0x08 register, error %d\n", error);
-		goto out;
+		dev_err_ratelimited(&client->dev,
+				    "failed to write 0x08 register, error %d\n",
+				    error);
+		return error;
 	}
 
 	do {
 		usleep_range(EDT_RAW_DATA_DELAY, EDT_RAW_DATA_DELAY + 100);
 		error = regmap_read(tsdata->regmap, 0x08, &val);
 		if (error) {
-			dev_err(&client->dev,
-				"failed to read 0x08 register, error %d\n",
-				error);
-			goto out;
+			dev_err_ratelimited(&client->dev,
+					    "failed to read 0x08 register, error %d\n",
+					    error);
+			return error;
 		}
 
 		if (val == 1)
@@ -856,24 +1454,50 @@ static ssize_t edt_ft5x06_debugfs_raw_data_read(struct file *file,
 	} while (--retries > 0);
 
 	if (retries == 0) {
-		dev_err(&client->dev,
-			"timed out waiting for register to settle\n");
-		error = -ETIMEDOUT;
-		goto out;
+		dev_err_ratelimited(&client->dev,
+				    "timed out waiting for register to settle\n");
+		return -ETIMEDOUT;
 	}
 
-	rdbuf = tsdata->raw_buffer;
+	if (ts)
+		*ts = ktime_get_ns();
+
 	colbytes = tsdata->num_y * sizeof(u16);
 
 	for (i = 0; i < tsdata->num_x; i++) {
-		rdbuf[0] = i;  /* column index */
-		error = regmap_bulk_read(tsdata->regmap, 0xf5, rdbuf, colbytes);
+		buf[0] = i;  /* column index */
+		error = regmap_bulk_read(tsdata->regmap, 0xf5, buf, colbytes);
 		if (error)
-			goto out;
+			return error;
+
+		buf += colbytes;
+	}
+
+	return 0;
+}
+
+static ssize_t edt_ft5x06_debugfs_raw_data_read(struct file *file,
+						char __user *buf, size_t count,
+						loff_t *off)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	size_t read = 0;
+	int error;
 
-		rdbuf += colbytes;
+	if (*off < 0 || *off >= tsdata->raw_bufsize)
+		return 0;
+
+	mutex_lock(&tsdata->mutex);
+
+	if (!tsdata->factory_mode || !tsdata->raw_buffer) {
+		error = -EIO;
+		goto out;
 	}
 
+	error = edt_ft5x06_raw_scan(tsdata, tsdata->raw_buffer, NULL);
+	if (error)
+		goto out;
+
 	read = min_t(size_t, count, tsdata->raw_bufsize - *off);
 	if (copy_to_user(buf, tsdata->raw_buffer + *off, read)) {
 		error = -EFAULT;
@@ -891,9 +1515,452 @@ static const struct file_operations debugfs_raw_data_fops = {
 	.read = edt_ft5x06_debugfs_raw_data_read,
 };
 
+static void edt_ft5x06_stats_reset(struct edt_ft5x06_ts_data *tsdata)
+{
+	unsigned int i, nodes = tsdata->num_x * tsdata->num_y;
+
+	for (i = 0; i < nodes; i++) {
+		tsdata->stats_sum[i] = 0;
+		tsdata->stats_sumsq[i] = 0;
+		tsdata->stats_min[i] = U16_MAX;
+		tsdata->stats_max[i] = 0;
+	}
+
+	tsdata->stats_frames = 0;
+}
+
+static int edt_ft5x06_stats_alloc(struct edt_ft5x06_ts_data *tsdata)
+{
+	unsigned int nodes = tsdata->num_x * tsdata->num_y;
+
+	tsdata->stats_sum = kcalloc(nodes, sizeof(u32), GFP_KERNEL);
+	tsdata->stats_sumsq = kcalloc(nodes, sizeof(u64), GFP_KERNEL);
+	tsdata->stats_min = kcalloc(nodes, sizeof(u16), GFP_KERNEL);
+	tsdata->stats_max = kcalloc(nodes, sizeof(u16), GFP_KERNEL);
+	tsdata->stats = kcalloc(nodes, sizeof(*tsdata->stats), GFP_KERNEL);
+	if (!tsdata->stats_sum || !tsdata->stats_sumsq || !tsdata->stats_min ||
+	    !tsdata->stats_max || !tsdata->stats)
+		return -ENOMEM;
+
+	edt_ft5x06_stats_reset(tsdata);
+
+	return 0;
+}
+
+static void edt_ft5x06_stats_free(struct edt_ft5x06_ts_data *tsdata)
+{
+	kfree(tsdata->stats_sum);
+	kfree(tsdata->stats_sumsq);
+	kfree(tsdata->stats_min);
+	kfree(tsdata->stats_max);
+	kfree(tsdata->stats);
+	tsdata->stats = NULL;
+}
+
+static void edt_ft5x06_stats_publish(struct edt_ft5x06_ts_data *tsdata)
+{
+	unsigned int i, nodes = tsdata->num_x * tsdata->num_y;
+	u32 n = tsdata->stats_frames;
+	struct edt_ft5x06_node_stats *st;
+	u64 sum;
+	s32 delta;
+
+	for (i = 0; i < nodes; i++) {
+		st = &tsdata->stats[i];
+		sum = tsdata->stats_sum[i];
+
+		st->mean = div_u64(sum << 8, n);
+		st->var = div_u64(tsdata->stats_sumsq[i] * n - sum * sum, n * n);
+		st->min = tsdata->stats_min[i];
+		st->max = tsdata->stats_max[i];
+
+		if (tsdata->stats_windows) {
+			delta = (s32)st->mean - (s32)st->baseline;
+			st->baseline += delta >> EDT_STATS_BASELINE_SHIFT;
+		} else {
+			st->baseline = st->mean;
+		}
+	}
+
+	tsdata->stats_windows++;
+	edt_ft5x06_stats_reset(tsdata);
+}
+
+/* raw frames come in as big endian counts, num_x columns of num_y nodes */
+static void edt_ft5x06_stats_add(struct edt_ft5x06_ts_data *tsdata,
+				 const __be16 *data)
+{
+	unsigned int i, nodes = tsdata->num_x * tsdata->num_y;
+	u16 v;
+
+	mutex_lock(&tsdata->stats_mutex);
+
+	for (i = 0; i < nodes; i++) {
+		v = be16_to_cpu(data[i]);
+		tsdata->stats_sum[i] += v;
+		tsdata->stats_sumsq[i] += (u32)v * v;
+		tsdata->stats_min[i] = min(tsdata->stats_min[i], v);
+		tsdata->stats_max[i] = max(tsdata->stats_max[i], v);
+	}
+
+	if (++tsdata->stats_frames >= tsdata->stats_window)
+		edt_ft5x06_stats_publish(tsdata);
+
+	mutex_unlock(&tsdata->stats_mutex);
+}
+
+static int edt_ft5x06_raw_ring_thread(void *data)
+{
+	struct edt_ft5x06_ts_data *tsdata = data;
+	struct edt_ft5x06_raw_ring *ring = tsdata->raw_ring;
+	struct edt_ft5x06_raw_frame *frame;
+	u32 seq = ring->head;
+	u64 ts;
+	int error;
+
+	set_freezable();
+
+	while (!kthread_freezable_should_stop(NULL)) {
+		/* 0 marks a slot being written, skip it on wrap */
+		if (!++seq)
+			seq = 1;
+
+		frame = (void *)ring + ring->data_offset +
+			(seq % ring->frames) * ring->frame_size;
+		WRITE_ONCE(frame->seq, 0);
+		smp_wmb();
+
+		mutex_lock(&tsdata->mutex);
+		error = tsdata->factory_mode ?
+			edt_ft5x06_raw_scan(tsdata, (u8 *)frame->data, &ts) :
+			-EIO;
+		mutex_unlock(&tsdata->mutex);
+
+		if (error) {
+			ring->errors++;
+			seq--;
+			msleep_interruptible(EDT_RAW_RING_IDLE_MS);
+			continue;
+		}
+
+		frame->ts_ns = ts;
+		smp_wmb();
+		WRITE_ONCE(frame->seq, seq);
+		smp_store_release(&ring->head, seq);
+
+		edt_ft5x06_stats_add(tsdata, (const __be16 *)frame->data);
+	}
+
+	return 0;
+}
+
+static int edt_ft5x06_raw_ring_start(struct edt_ft5x06_ts_data *tsdata)
+{
+	struct edt_ft5x06_raw_ring *ring = tsdata->raw_ring;
+	struct task_struct *task;
+	size_t frame_size;
+	int error;
+
+	if (tsdata->raw_task)
+		return 0;
+
+	if (tsdata->version != EDT_M06)
+		return -EINVAL;
+
+	if (!ring) {
+		mutex_lock(&tsdata->stats_mutex);
+		error = tsdata->stats ? 0 : edt_ft5x06_stats_alloc(tsdata);
+		if (error)
+			edt_ft5x06_stats_free(tsdata);
+		mutex_unlock(&tsdata->stats_mutex);
+		if (error)
+			return error;
+
+		frame_size = ALIGN(sizeof(struct edt_ft5x06_raw_frame) +
+				   tsdata->num_x * tsdata->num_y * sizeof(u16),
+				   SMP_CACHE_BYTES);
+		tsdata->raw_ring_size = PAGE_ALIGN(SMP_CACHE_BYTES +
+						   EDT_RAW_RING_FRAMES *
+						   frame_size);
+
+		ring = vmalloc_user(tsdata->raw_ring_size);
+		if (!ring)
+			return -ENOMEM;
+
+		ring->frames = EDT_RAW_RING_FRAMES;
+		ring->frame_size = frame_size;
+		ring->data_offset = SMP_CACHE_BYTES;
+		ring->num_x = tsdata->num_x;
+		ring->num_y = tsdata->num_y;
+		tsdata->raw_ring = ring;
+	}
+
+	task = kthread_run(edt_ft5x06_raw_ring_thread, tsdata, "%s-raw",
+			   dev_name(&tsdata->client->dev));
+	if (IS_ERR(task))
+		return PTR_ERR(task);
+
+	tsdata->raw_task = task;
+
+	return 0;
+}
+
+static void edt_ft5x06_raw_ring_stop(struct edt_ft5x06_ts_data *tsdata)
+{
+	if (tsdata->raw_task) {
+		kthread_stop(tsdata->raw_task);
+		tsdata->raw_task = NULL;
+	}
+}
+
+/*
+ * debugfs raw_ring: writing 1 starts scanning raw frames into the ring back
+ * to back, 0 stops. Frames are only captured while in factory mode, the
+ * thread keeps running across mode switches. The ring stays allocated, and
+ * mapped, until the driver goes away. Captured frames also feed debugfs stats.
+ */
+static ssize_t edt_ft5x06_debugfs_raw_ring_write(struct file *file,
+						 const char __user *buf,
+						 size_t count, loff_t *off)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	bool on;
+	int error;
+
+	error = kstrtobool_from_user(buf, count, &on);
+	if (error)
+		return error;
+
+	/* created unsafe, keep the driver from going away under us */
+	error = debugfs_file_get(file->f_path.dentry);
+	if (error)
+		return error;
+
+	mutex_lock(&tsdata->raw_ring_mutex);
+	if (on)
+		error = edt_ft5x06_raw_ring_start(tsdata);
+	else
+		edt_ft5x06_raw_ring_stop(tsdata);
+	mutex_unlock(&tsdata->raw_ring_mutex);
+
+	debugfs_file_put(file->f_path.dentry);
+
+	return error ?: count;
+}
+
+static int edt_ft5x06_debugfs_raw_ring_mmap(struct file *file,
+					    struct vm_area_struct *vma)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	int error;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vm_flags_clear(vma, VM_MAYWRITE);
+
+	error = debugfs_file_get(file->f_path.dentry);
+	if (error)
+		return error;
+
+	mutex_lock(&tsdata->raw_ring_mutex);
+	error = tsdata->raw_ring ?
+		remap_vmalloc_range(vma, tsdata->raw_ring, vma->vm_pgoff) :
+		-ENODEV;
+	mutex_unlock(&tsdata->raw_ring_mutex);
+
+	debugfs_file_put(file->f_path.dentry);
+
+	return error;
+}
+
+static const struct file_operations debugfs_raw_ring_fops = {
+	.open = simple_open,
+	.write = edt_ft5x06_debugfs_raw_ring_write,
+	.mmap = edt_ft5x06_debugfs_raw_ring_mmap,
+};
+
+static int edt_ft5x06_debugfs_stats_window_get(void *data, u64 *window)
+{
+	struct edt_ft5x06_ts_data *tsdata = data;
+
+	*window = tsdata->stats_window;
+
+	return 0;
+}
+
+static int edt_ft5x06_debugfs_stats_window_set(void *data, u64 window)
+{
+	struct edt_ft5x06_ts_data *tsdata = data;
+
+	if (window < 2 || window > EDT_STATS_WINDOW_MAX)
+		return -ERANGE;
+
+	mutex_lock(&tsdata->stats_mutex);
+	tsdata->stats_window = window;
+	if (tsdata->stats)
+		edt_ft5x06_stats_reset(tsdata);
+	mutex_unlock(&tsdata->stats_mutex);
+
+	return 0;
+}
+
+DEFINE_SIMPLE_ATTRIBUTE(debugfs_stats_window_fops,
+			edt_ft5x06_debugfs_stats_window_get,
+			edt_ft5x06_debugfs_stats_window_set, "%llu\n");
+
+/* 1/256 counts to "counts.hundredths" */
+#define EDT_Q8_FMT		"%u.%02u"
+#define EDT_Q8_ARG(q)		(q) >> 8, (((q) & 0xff) * 100) >> 8
+
+/*
+ * debugfs stats: panel summary of the last window. Noise is the per node
+ * standard deviation, drift the distance of a node's mean from its
+ * baseline, range its max - min.
+ */
+static int edt_ft5x06_stats_show(struct seq_file *s, void *data)
+{
+	struct edt_ft5x06_ts_data *tsdata = s->private;
+	unsigned int i, nodes = tsdata->num_x * tsdata->num_y;
+	unsigned int noise_node = 0, drift_node = 0, range_node = 0;
+	u32 noise, noise_max = 0, drift, drift_max = 0, range, range_max = 0;
+	const struct edt_ft5x06_node_stats *st;
+	u64 noise_sum = 0;
+
+	mutex_lock(&tsdata->stats_mutex);
+
+	seq_printf(s, "window: %u\n", tsdata->stats_window);
+	seq_printf(s, "windows: %u\n", tsdata->stats_windows);
+	if (!tsdata->stats || !tsdata->stats_windows || !nodes)
+		goto out;
+
+	for (i = 0; i < nodes; i++) {
+		st = &tsdata->stats[i];
+
+		noise = int_sqrt64((u64)st->var << 16);
+		noise_sum += noise;
+		if (noise > noise_max) {
+			noise_max = noise;
+			noise_node = i;
+		}
+
+		drift = abs((s32)st->mean - (s32)st->baseline);
+		if (drift > drift_max) {
+			drift_max = drift;
+			drift_node = i;
+		}
+
+		range = st->max - st->min;
+		if (range > range_max) {
+			range_max = range;
+			range_node = i;
+		}
+	}
+
+	noise = div_u64(noise_sum, nodes);
+	seq_printf(s, "noise: " EDT_Q8_FMT " max " EDT_Q8_FMT " at %u,%u\n",
+		   EDT_Q8_ARG(noise), EDT_Q8_ARG(noise_max),
+		   noise_node / tsdata->num_y, noise_node % tsdata->num_y);
+	seq_printf(s, "drift: max " EDT_Q8_FMT " at %u,%u\n",
+		   EDT_Q8_ARG(drift_max),
+		   drift_node / tsdata->num_y, drift_node % tsdata->num_y);
+	seq_printf(s, "range: max %u at %u,%u\n", range_max,
+		   range_node / tsdata->num_y, range_node % tsdata->num_y);
+out:
+	mutex_unlock(&tsdata->stats_mutex);
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(edt_ft5x06_stats);
+
+/* debugfs stats_nodes: struct edt_ft5x06_node_stats per node, raw order */
+static ssize_t edt_ft5x06_debugfs_stats_nodes_read(struct file *file,
+						   char __user *buf,
+						   size_t count, loff_t *off)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	size_t size = tsdata->num_x * tsdata->num_y * sizeof(*tsdata->stats);
+	ssize_t read = 0;
+
+	mutex_lock(&tsdata->stats_mutex);
+	if (tsdata->stats && tsdata->stats_windows)
+		read = simple_read_from_buffer(buf, count, off,
+					       tsdata->stats, size);
+	mutex_unlock(&tsdata->stats_mutex);
+
+	return read;
+}
+
+static const struct file_operations debugfs_stats_nodes_fops = {
+	.open = simple_open,
+	.read = edt_ft5x06_debugfs_stats_nodes_read,
+};
+
+/*
+ * debugfs latency: writing 1 starts a fresh run of per report stage times,
+ * 0 stops it. Reads return whole struct edt_ft5x06_lat records, oldest
+ * first, and consume them.
+ */
+static ssize_t edt_ft5x06_debugfs_lat_read(struct file *file, char __user *buf,
+					   size_t count, loff_t *off)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	unsigned int copied = 0;
+	int error;
+
+	mutex_lock(&tsdata->lat_mutex);
+	error = kfifo_to_user(&tsdata->lat_fifo, buf, count, &copied);
+	mutex_unlock(&tsdata->lat_mutex);
+
+	return error ?: copied;
+}
+
+static ssize_t edt_ft5x06_debugfs_lat_write(struct file *file,
+					    const char __user *buf,
+					    size_t count, loff_t *off)
+{
+	struct edt_ft5x06_ts_data *tsdata = file->private_data;
+	bool on;
+	int error;
+
+	error = kstrtobool_from_user(buf, count, &on);
+	if (error)
+		return error;
+
+	mutex_lock(&tsdata->lat_mutex);
+
+	WRITE_ONCE(tsdata->lat_on, false);
+	/* the report in flight may still log once */
+	if (tsdata->client->irq)
+		synchronize_irq(tsdata->client->irq);
+	flush_work(&tsdata->work_i2c_poll);
+
+	kfifo_reset(&tsdata->lat_fifo);
+	tsdata->lat_seq = 0;
+	WRITE_ONCE(tsdata->lat_on, on);
+
+	mutex_unlock(&tsdata->lat_mutex);
+
+	return count;
+}
+
+static const struct file_operations debugfs_lat_fops = {
+	.open = simple_open,
+	.read = edt_ft5x06_debugfs_lat_read,
+	.write = edt_ft5x06_debugfs_lat_write,
+};
+
 static void edt_ft5x06_ts_prepare_debugfs(struct edt_ft5x06_ts_data *tsdata,
 					  const char *debugfs_name)
 {
+	mutex_init(&tsdata->lat_mutex);
+	mutex_init(&tsdata->raw_ring_mutex);
+	mutex_init(&tsdata->stats_mutex);
+	tsdata->stats_window = EDT_STATS_WINDOW;
+	if (kfifo_alloc(&tsdata->lat_fifo, EDT_LAT_RECORDS, GFP_KERNEL))
+		dev_warn(&tsdata->client->dev, "no memory for latency records\n");
+
 	tsdata->debug_dir = debugfs_create_dir(debugfs_name, NULL);
 
 	debugfs_create_u16("num_x", S_IRUSR, tsdata->debug_dir, &tsdata->num_x);
@@ -903,12 +1970,29 @@ static void edt_ft5x06_ts_prepare_debugfs(struct edt_ft5x06_ts_data *tsdata,
 			    tsdata->debug_dir, tsdata, &debugfs_mode_fops);
 	debugfs_create_file("raw_data", S_IRUSR,
 			    tsdata->debug_dir, tsdata, &debugfs_raw_data_fops);
+	/* the full proxy fops debugfs_create_file() installs drop .mmap */
+	debugfs_create_file_unsafe("raw_ring", S_IRUSR | S_IWUSR,
+				   tsdata->debug_dir, tsdata,
+				   &debugfs_raw_ring_fops);
+	debugfs_create_file("stats_window", S_IRUSR | S_IWUSR,
+			    tsdata->debug_dir, tsdata, &debugfs_stats_window_fops);
+	debugfs_create_file("stats", S_IRUSR,
+			    tsdata->debug_dir, tsdata, &edt_ft5x06_stats_fops);
+	debugfs_create_file("stats_nodes", S_IRUSR,
+			    tsdata->debug_dir, tsdata, &debugfs_stats_nodes_fops);
+	if (kfifo_initialized(&tsdata->lat_fifo))
+		debugfs_create_file("latency", S_IRUSR | S_IWUSR,
+				    tsdata->debug_dir, tsdata, &debugfs_lat_fops);
 }
 
 static void edt_ft5x06_ts_teardown_debugfs(struct edt_ft5x06_ts_data *tsdata)
 {
 	debugfs_remove_recursive(tsdata->debug_dir);
+	edt_ft5x06_raw_ring_stop(tsdata);
+	vfree(tsdata->raw_ring);
+	edt_ft5x06_stats_free(tsdata);
 	kfree(tsdata->raw_buffer);
+	kfifo_free(&tsdata->lat_fifo);
 }
 
 #else
@@ -1055,6 +2139,44 @@ static int edt_ft5x06_ts_identify(struct i2c_client *client,
 	return 0;
 }
 
+/*
+ * Hand what the controller holds after reset, before the board's overrides,
+ * to regmap as register defaults: regcache_sync() after a power cycle then
+ * only writes the registers DT or sysfs changed.
+ */
+static int edt_ft5x06_ts_init_reg_defaults(struct edt_ft5x06_ts_data *tsdata)
+{
+	struct edt_reg_addr *reg_addr = &tsdata->reg_addr;
+	const int regs[] = {
+		reg_addr->reg_threshold, reg_addr->reg_report_rate,
+		reg_addr->reg_gain, reg_addr->reg_offset,
+		reg_addr->reg_offset_x, reg_addr->reg_offset_y,
+	};
+	struct reg_default defaults[ARRAY_SIZE(regs)];
+	struct regmap_config config;
+	unsigned int i, n = 0;
+
+	/* a register that does not read back just gets no default */
+	for (i = 0; i < ARRAY_SIZE(regs); i++) {
+		if (regs[i] == NO_REGISTER)
+			continue;
+
+		defaults[n].reg = regs[i];
+		if (!regmap_read(tsdata->regmap, regs[i], &defaults[n].def))
+			n++;
+	}
+
+	if (tsdata->version == EDT_M06)
+		config = edt_M06_i2c_regmap_config;
+	else
+		config = edt_ft5x06_i2c_regmap_config;
+	config.reg_defaults = defaults;
+	config.num_reg_defaults = n;
+
+	/* regmap keeps its own copy of the defaults */
+	return regmap_reinit_cache(tsdata->regmap, &config);
+}
+
 static void edt_ft5x06_ts_get_defaults(struct device *dev,
 				       struct edt_ft5x06_ts_data *tsdata)
 {
@@ -1318,6 +2440,16 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 		return error;
 	}
 
+	/* optional, the panel's TE output to lock reads to scanout */
+	tsdata->vsync_gpio = devm_gpiod_get_optional(&client->dev,
+						     "vsync", GPIOD_IN);
+	if (IS_ERR(tsdata->vsync_gpio)) {
+		error = PTR_ERR(tsdata->vsync_gpio);
+		dev_err(&client->dev,
+			"Failed to request GPIO vsync pin, error %d\n", error);
+		return error;
+	}
+
 	/*
 	 * Check which sleep modes we can support. Power-off requieres the
 	 * reset-pin to ensure correct power-down/power-up behaviour. Start with
@@ -1351,6 +2483,10 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 
 	mutex_init(&tsdata->mutex);
 	tsdata->client = client;
+	tsdata->poll_min_us = POLL_MIN_US;
+	tsdata->poll_max_us = POLL_MAX_US;
+	tsdata->hybrid_exit_ms = HYBRID_EXIT_MS;
+	tsdata->vsync_offset_us = VSYNC_OFFSET_US;
 	tsdata->input = input;
 	tsdata->factory_mode = false;
 	i2c_set_clientdata(client, tsdata);
@@ -1369,6 +2505,14 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 
 	edt_ft5x06_ts_set_tdata_parameters(tsdata);
 	edt_ft5x06_ts_set_regs(tsdata);
+
+	error = edt_ft5x06_ts_init_reg_defaults(tsdata);
+	if (error) {
+		dev_err(&client->dev, "failed to set up the register cache: %d\n",
+			error);
+		return error;
+	}
+
 	edt_ft5x06_ts_get_defaults(&client->dev, tsdata);
 	edt_ft5x06_ts_get_parameters(tsdata);
 
@@ -1414,6 +2558,11 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 		return error;
 	}
 
+	/* the poller also backs the IRQ in hybrid mode */
+	INIT_WORK(&tsdata->work_i2c_poll, edt_ft5x06_ts_work_i2c_poll);
+	hrtimer_init(&tsdata->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	tsdata->timer.function = edt_ft5x06_ts_irq_poll_timer;
+
 	if (client->irq) {
 		irq_flags = irq_get_trigger_type(client->irq);
 		if (irq_flags == IRQF_TRIGGER_NONE)
@@ -1421,7 +2570,8 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 		irq_flags |= IRQF_ONESHOT;
 
 		error = devm_request_threaded_irq(&client->dev, client->irq,
-						  NULL, edt_ft5x06_ts_isr,
+						  edt_ft5x06_ts_hardirq,
+						  edt_ft5x06_ts_isr,
 						  irq_flags, client->name,
 						  tsdata);
 		if (error) {
@@ -1430,12 +2580,26 @@ static int edt_ft5x06_ts_probe(struct i2c_client *client)
 		}
 	} else {
 		tsdata->init_td_status = -1; /* filter bogus initial data */
-		INIT_WORK(&tsdata->work_i2c_poll,
-			  edt_ft5x06_ts_work_i2c_poll);
-		timer_setup(&tsdata->timer, edt_ft5x06_ts_irq_poll_timer, 0);
-		tsdata->timer.expires =
-			jiffies + msecs_to_jiffies(FIRST_POLL_DELAY_MS);
-		add_timer(&tsdata->timer);
+		tsdata->poll_us = tsdata->poll_max_us;
+		hrtimer_start(&tsdata->timer, ms_to_ktime(FIRST_POLL_DELAY_MS),
+			      HRTIMER_MODE_REL);
+	}
+
+	if (tsdata->vsync_gpio) {
+		tsdata->vsync_irq = gpiod_to_irq(tsdata->vsync_gpio);
+		if (tsdata->vsync_irq < 0) {
+			dev_err(&client->dev, "vsync pin has no IRQ.\n");
+			return tsdata->vsync_irq;
+		}
+
+		error = devm_request_irq(&client->dev, tsdata->vsync_irq,
+					 edt_ft5x06_ts_vsync_isr,
+					 IRQF_TRIGGER_RISING, "edt-ft5x06-vsync",
+					 tsdata);
+		if (error) {
+			dev_err(&client->dev, "Unable to request vsync IRQ.\n");
+			return error;
+		}
 	}
 
 	error = devm_device_add_group(&client->dev, &edt_ft5x06_attr_group);
@@ -1461,10 +2625,7 @@ static void edt_ft5x06_ts_remove(struct i2c_client *client)
 {
 	struct edt_ft5x06_ts_data *tsdata = i2c_get_clientdata(client);
 
-	if (!client->irq) {
-		del_timer(&tsdata->timer);
-		cancel_work_sync(&tsdata->work_i2c_poll);
-	}
+	edt_ft5x06_ts_stop_polling(tsdata);
 	edt_ft5x06_ts_teardown_debugfs(tsdata);
 }
 
@@ -1475,6 +2636,9 @@ static int edt_ft5x06_ts_suspend(struct device *dev)
 	struct gpio_desc *reset_gpio = tsdata->reset_gpio;
 	int ret;
 
+	/* the poller must not outlive the bus, and wakeups come by IRQ */
+	edt_ft5x06_ts_hybrid_leave(tsdata);
+
 	if (device_may_wakeup(dev))
 		return 0;
 
@@ -1557,7 +2721,8 @@ static int edt_ft5x06_ts_resume(struct device *dev)
 		gpiod_set_value_cansleep(reset_gpio, 0);
 		msleep(300);
 
-		edt_ft5x06_restore_reg_parameters(tsdata);
+		if (edt_ft5x06_restore_reg_parameters(tsdata))
+			dev_warn(dev, "Failed to restore registers\n");
 		enable_irq(tsdata->client->irq);
 
 		if (tsdata->factory_mode)
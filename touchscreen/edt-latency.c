@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Touch latency per pipeline stage for edt-ft5x06.
+ *
+ * Turns on the driver's latency mode, reads the touchscreen's evdev node
+ * and the driver's per report stage times from debugfs, joins the two by
+ * timestamp (the evdev event time is the driver's IRQ stamp) and prints
+ * latency and jitter histograms per stage:
+ *
+ *	wakeup	IRQ edge (or poll start) to the handler running
+ *	i2c	report read from the controller
+ *	report	decode and input_sync()
+ *	evdev	input_sync() to this tool's read() returning
+ *	total	IRQ edge to read()
+ *
+ * Jitter is the change of a stage's latency from one report to the next.
+ * A report that changed nothing sends no evdev frame and is skipped.
+ * The photon end of the chain needs a light sensor and is not covered,
+ * the evdev read is where a compositor would pick the report up.
+ *
+ * Works against real hardware or edt-ft5x06-mock.ko on any machine:
+ *
+ *	make MOCK=1 && make edt-latency
+ *	insmod edt-ft5x06.ko && insmod edt-ft5x06-mock.ko
+ *	./edt-latency -n 2000
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <glob.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+#include <sys/ioctl.h>
+
+/* struct edt_ft5x06_lat in edt-ft5x06.c */
+struct edt_lat {
+	uint32_t seq;
+	uint32_t points;
+	uint64_t irq_ns;
+	uint64_t thread_ns;
+	uint64_t read_ns;
+	uint64_t sync_ns;
+};
+
+#define LAT_PATH	"/sys/kernel/debug/edt_ft5x06/latency"
+#define RING		4096		/* reports in flight on either side */
+#define HIST		16		/* log2(us) buckets */
+
+enum stage {
+	STAGE_WAKEUP,
+	STAGE_I2C,
+	STAGE_REPORT,
+	STAGE_EVDEV,
+	STAGE_TOTAL,
+	NUM_STAGES,
+};
+
+static const char * const stage_names[NUM_STAGES] = {
+	[STAGE_WAKEUP] = "wakeup",
+	[STAGE_I2C] = "i2c",
+	[STAGE_REPORT] = "report",
+	[STAGE_EVDEV] = "evdev",
+	[STAGE_TOTAL] = "total",
+};
+
+struct frame {
+	uint64_t ev_us;		/* evdev event time, the driver's IRQ stamp */
+	uint64_t user_ns;	/* our read() returned */
+};
+
+/*
+ * Both sides arrive in report order, so joining is a merge: records and
+ * frames wait in their queue until the head of the other side catches up.
+ */
+static struct edt_lat kq[RING];
+static struct frame uq[RING];
+static unsigned int k_head, k_tail, u_head, u_tail;
+
+static double *samples[NUM_STAGES];
+static unsigned int num_samples, max_samples = 1000;
+static unsigned int k_only, u_only;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+	stop = 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int write_str(const char *path, const char *s)
+{
+	int fd = open(path, O_WRONLY);
+	ssize_t ret;
+
+	if (fd < 0)
+		return -errno;
+
+	ret = write(fd, s, strlen(s));
+	close(fd);
+
+	return ret < 0 ? -errno : 0;
+}
+
+/* first I2C evdev node that carries MT slots */
+static int find_touch(char *path, size_t len)
+{
+	unsigned long abs[ABS_CNT / (8 * sizeof(long)) + 1] = { 0 };
+	struct input_id id;
+	glob_t g;
+	size_t i;
+	int fd;
+
+	if (glob("/dev/input/event*", 0, NULL, &g))
+		return -ENOENT;
+
+	for (i = 0; i < g.gl_pathc; i++) {
+		fd = open(g.gl_pathv[i], O_RDONLY);
+		if (fd < 0)
+			continue;
+
+		memset(&id, 0, sizeof(id));
+		memset(abs, 0, sizeof(abs));
+		ioctl(fd, EVIOCGID, &id);
+		ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs);
+		close(fd);
+
+		if (id.bustype == BUS_I2C &&
+		    (abs[ABS_MT_SLOT / (8 * sizeof(long))] &
+		     (1UL << (ABS_MT_SLOT % (8 * sizeof(long)))))) {
+			snprintf(path, len, "%s", g.gl_pathv[i]);
+			globfree(&g);
+			return 0;
+		}
+	}
+
+	globfree(&g);
+
+	return -ENOENT;
+}
+
+static void sample(const struct edt_lat *k, const struct frame *f)
+{
+	double *v[NUM_STAGES];
+	int i;
+
+	if (num_samples >= max_samples)
+		return;
+
+	for (i = 0; i < NUM_STAGES; i++)
+		v[i] = &samples[i][num_samples];
+
+	*v[STAGE_WAKEUP] = (k->thread_ns - k->irq_ns) / 1e3;
+	*v[STAGE_I2C] = (k->read_ns - k->thread_ns) / 1e3;
+	*v[STAGE_REPORT] = (k->sync_ns - k->read_ns) / 1e3;
+	*v[STAGE_EVDEV] = ((int64_t)(f->user_ns - k->sync_ns)) / 1e3;
+	*v[STAGE_TOTAL] = ((int64_t)(f->user_ns - k->irq_ns)) / 1e3;
+
+	num_samples++;
+}
+
+/*
+ * evdev time is the driver's IRQ stamp, to the microsecond. Whichever
+ * head is older has no partner on the other side: a record of a report
+ * that changed nothing, or a frame whose record the driver dropped.
+ */
+static void join(void)
+{
+	while (k_head != k_tail && u_head != u_tail) {
+		const struct edt_lat *k = &kq[k_tail % RING];
+		const struct frame *f = &uq[u_tail % RING];
+		uint64_t k_us = k->irq_ns / 1000;
+
+		if (k_us == f->ev_us) {
+			sample(k, f);
+			k_tail++;
+			u_tail++;
+		} else if (k_us < f->ev_us) {
+			k_only++;
+			k_tail++;
+		} else {
+			u_only++;
+			u_tail++;
+		}
+	}
+}
+
+static void read_kernel(int fd)
+{
+	struct edt_lat buf[256];
+	ssize_t n;
+	int i;
+
+	while ((n = read(fd, buf, sizeof(buf))) > 0) {
+		for (i = 0; i < n / (ssize_t)sizeof(buf[0]); i++) {
+			/* the other side stalled, its oldest partners are gone */
+			if (k_head - k_tail == RING) {
+				k_only++;
+				k_tail++;
+			}
+			kq[k_head++ % RING] = buf[i];
+		}
+		join();
+	}
+}
+
+static void read_evdev(int fd)
+{
+	struct input_event ev[64];
+	uint64_t t;
+	ssize_t n;
+	int i;
+
+	n = read(fd, ev, sizeof(ev));
+	if (n <= 0)
+		return;
+
+	t = now_ns();
+
+	for (i = 0; i < n / (ssize_t)sizeof(ev[0]); i++) {
+		struct frame *f;
+
+		if (ev[i].type != EV_SYN || ev[i].code != SYN_REPORT)
+			continue;
+
+		if (u_head - u_tail == RING) {
+			u_only++;
+			u_tail++;
+		}
+		f = &uq[u_head++ % RING];
+		f->ev_us = (uint64_t)ev[i].input_event_sec * 1000000 +
+			   ev[i].input_event_usec;
+		f->user_ns = t;
+	}
+
+	join();
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void hist(const double *v, unsigned int n, unsigned int *h)
+{
+	unsigned int i, b;
+
+	memset(h, 0, HIST * sizeof(*h));
+	for (i = 0; i < n; i++) {
+		double us = v[i] < 1 ? 1 : v[i];
+
+		b = (unsigned int)log2(us);
+		h[b < HIST ? b : HIST - 1]++;
+	}
+}
+
+static void report(void)
+{
+	unsigned int h[NUM_STAGES][HIST], hj[NUM_STAGES][HIST];
+	unsigned int i, j, n = num_samples;
+	double *jit;
+
+	printf("reports: %u, without evdev frame: %u, without driver record: %u\n",
+	       n, k_only, u_only);
+	if (n < 2)
+		return;
+
+	jit = calloc(n, sizeof(*jit));
+	if (!jit)
+		return;
+
+	printf("%-8s %9s %9s %9s %9s %9s %9s  (us)\n", "stage", "min", "mean",
+	       "p50", "p99", "max", "jitter");
+
+	for (i = 0; i < NUM_STAGES; i++) {
+		double *v = samples[i], sum = 0, jsum = 0;
+
+		for (j = 1; j < n; j++) {
+			jit[j - 1] = fabs(v[j] - v[j - 1]);
+			jsum += jit[j - 1];
+		}
+		hist(jit, n - 1, hj[i]);
+
+		hist(v, n, h[i]);
+		for (j = 0; j < n; j++)
+			sum += v[j];
+		qsort(v, n, sizeof(*v), cmp_double);
+
+		printf("%-8s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+		       stage_names[i], v[0], sum / n, v[n / 2],
+		       v[(n - 1) * 99 / 100], v[n - 1], jsum / (n - 1));
+	}
+
+	printf("latency histogram, log2(us) buckets\n");
+	for (i = 0; i < NUM_STAGES; i++) {
+		printf("%-8s", stage_names[i]);
+		for (j = 0; j < HIST; j++)
+			printf(" %u", h[i][j]);
+		putchar('\n');
+	}
+
+	printf("jitter histogram, log2(us) buckets\n");
+	for (i = 0; i < NUM_STAGES; i++) {
+		printf("%-8s", stage_names[i]);
+		for (j = 0; j < HIST; j++)
+			printf(" %u", hj[i][j]);
+		putchar('\n');
+	}
+
+	free(jit);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d /dev/input/eventN] [-l latency file] [-n reports]\n"
+		"  -d  touchscreen evdev node, default the first I2C one with MT slots\n"
+		"  -l  driver latency records, default " LAT_PATH "\n"
+		"  -n  reports to collect, default 1000, Ctrl-C stops early\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *lat_path = LAT_PATH;
+	char dev_path[256] = "";
+	struct pollfd pfd[1];
+	int ev_fd, lat_fd, clk = CLOCK_MONOTONIC;
+	int opt, i, ret;
+
+	while ((opt = getopt(argc, argv, "d:l:n:h")) != -1) {
+		switch (opt) {
+		case 'd':
+			snprintf(dev_path, sizeof(dev_path), "%s", optarg);
+			break;
+		case 'l':
+			lat_path = optarg;
+			break;
+		case 'n':
+			max_samples = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!max_samples) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!dev_path[0] && find_touch(dev_path, sizeof(dev_path))) {
+		fprintf(stderr, "no I2C touchscreen found, use -d\n");
+		return 1;
+	}
+
+	for (i = 0; i < NUM_STAGES; i++) {
+		samples[i] = calloc(max_samples, sizeof(double));
+		if (!samples[i])
+			return 1;
+	}
+
+	ev_fd = open(dev_path, O_RDONLY | O_NONBLOCK);
+	if (ev_fd < 0) {
+		perror(dev_path);
+		return 1;
+	}
+
+	/* event times in the driver's clock */
+	if (ioctl(ev_fd, EVIOCSCLOCKID, &clk)) {
+		perror("EVIOCSCLOCKID");
+		return 1;
+	}
+
+	ret = write_str(lat_path, "1");
+	if (ret) {
+		fprintf(stderr, "%s: %s\n", lat_path, strerror(-ret));
+		return 1;
+	}
+
+	lat_fd = open(lat_path, O_RDONLY | O_NONBLOCK);
+	if (lat_fd < 0) {
+		perror(lat_path);
+		write_str(lat_path, "0");
+		return 1;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	fprintf(stderr, "%s: collecting %u reports\n", dev_path, max_samples);
+
+	pfd[0].fd = ev_fd;
+	pfd[0].events = POLLIN;
+
+	while (!stop && num_samples < max_samples) {
+		/* debugfs does not poll, so its records are picked up in passing */
+		ret = poll(pfd, 1, 100);
+		if (ret < 0 && errno != EINTR)
+			break;
+
+		if (ret > 0)
+			read_evdev(ev_fd);
+		read_kernel(lat_fd);
+	}
+
+	read_kernel(lat_fd);
+	write_str(lat_path, "0");
+	close(lat_fd);
+	close(ev_fd);
+
+	report();
+
+	return 0;
+}